@@ -5,23 +5,992 @@
  * @copyright Copyright (c) 2023-2024
  */
 
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
 #include <cstdlib>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #include "ai.h"
-#include "controller.h"
+#include "bitops.h"
+#include "eval.h"
+#include "tt.h"
+#include "book.h"
+#include "log.h"
 
-Square getBestMove(GameModel &model)
+#define MAX_PLY 64
+
+// Aspiration window half-width around the previous iteration's score
+#define ASPIRATION_WINDOW (2 * SCORE_DISC)
+
+// Depth of the midgame search run before an endgame solve that may be cut
+// short; its move is played if the solve does not finish
+#define ENDGAME_FALLBACK_DEPTH 8
+
+/**
+ * @brief Per-search state, passed down the tree.
+ */
+struct SearchContext
+{
+    int threadIndex;
+    uint64_t nodes;
+    uint64_t maxNodes;
+    std::chrono::steady_clock::time_point start;
+    const std::atomic<double> *maxTime;
+    bool stop;
+    std::atomic<bool> *sharedStop;
+    std::atomic<bool> *externalStop;
+
+    // Pattern indices, kept in step with the searched position
+    EvalState eval;
+    const int16_t *evalWeights;
+
+    int pv[MAX_PLY][MAX_PLY];
+    int pvLength[MAX_PLY];
+
+    // Statistics; liveNodes is published after each iteration
+    uint64_t ttProbes;
+    uint64_t ttHits;
+    uint64_t betaCutoffs;
+    uint64_t cutoffsAt[SEARCH_CUTOFF_SLOTS];
+    std::atomic<uint64_t> liveNodes;
+};
+
+// Orden de jugadas: esquinas primero, casillas X y C al final
+static const int squareWeights[64] = {
+    100, -20, 10, 5, 5, 10, -20, 100,
+    -20, -50, -2, -2, -2, -2, -50, -20,
+    10, -2, -1, -1, -1, -1, -2, 10,
+    5, -2, -1, -1, -1, -1, -2, 5,
+    5, -2, -1, -1, -1, -1, -2, 5,
+    10, -2, -1, -1, -1, -1, -2, 10,
+    -20, -50, -2, -2, -2, -2, -50, -20,
+    100, -20, 10, 5, 5, 10, -20, 100,
+};
+
+static inline Square squareFromIndex(int sq)
+{
+    Square square = {sq / BOARD_SIZE, sq % BOARD_SIZE, (uint64_t)sq};
+    return square;
+}
+
+/**
+ * @brief Exact score of a finished game; empty squares go to the winner.
+ */
+static int finalScore(const Position &position)
+{
+    int me = popCount(position.getPlayer());
+    int opp = popCount(position.getOpponent());
+    int empties = 64 - me - opp;
+    int diff = me - opp;
+
+    if (diff > 0)
+        diff += empties;
+    else if (diff < 0)
+        diff -= empties;
+
+    return diff * SCORE_DISC;
+}
+
+static bool shouldStop(SearchContext &context, bool checkTime)
+{
+    if (context.stop)
+        return true;
+
+    if (context.sharedStop->load(std::memory_order_relaxed))
+        context.stop = true;
+    else if (context.threadIndex == 0)
+    {
+        // Only the main thread enforces the limits; helpers follow sharedStop
+        if (context.externalStop &&
+            context.externalStop->load(std::memory_order_relaxed))
+            context.stop = true;
+        else if (context.maxNodes && (context.nodes >= context.maxNodes))
+            context.stop = true;
+        else if (checkTime)
+        {
+            double maxTime = context.maxTime->load(std::memory_order_relaxed);
+            double elapsed = std::chrono::duration<double>(
+                                 std::chrono::steady_clock::now() - context.start)
+                                 .count();
+            if (maxTime > 0 && elapsed >= maxTime)
+                context.stop = true;
+        }
+
+        if (context.stop)
+            context.sharedStop->store(true, std::memory_order_relaxed);
+    }
+
+    return context.stop;
+}
+
+static bool shouldStop(SearchContext &context)
+{
+    return shouldStop(context, !(context.nodes & 1023));
+}
+
+static inline void countCutoff(SearchContext &context, int moveNumber)
+{
+    context.betaCutoffs++;
+    context.cutoffsAt[(moveNumber < SEARCH_CUTOFF_SLOTS) ? moveNumber : SEARCH_CUTOFF_SLOTS - 1]++;
+}
+
+static double getBranchingFactor(uint64_t nodes, int depth)
+{
+    return (nodes && depth > 0) ? pow((double)nodes, 1.0 / depth) : 0;
+}
+
+/**
+ * @brief Adds a thread's counters to the statistics.
+ */
+static void addStats(SearchStats &stats, const SearchContext &context)
+{
+    stats.ttProbes += context.ttProbes;
+    stats.ttHits += context.ttHits;
+    stats.betaCutoffs += context.betaCutoffs;
+    for (int i = 0; i < SEARCH_CUTOFF_SLOTS; i++)
+        stats.cutoffsAt[i] += context.cutoffsAt[i];
+}
+
+/**
+ * @brief Orders moves: transposition table move, static square value, then
+ * fewest opponent replies.
+ */
+static void orderMoves(Position &position, uint64_t moves, MoveList &list, int depth,
+                       int ttMove = TT_NO_MOVE)
+{
+    list.clear();
+
+    while (moves)
+    {
+        int sq = popLowestSquare(moves);
+        int score = squareWeights[sq] * 16;
+
+        if (sq == ttMove)
+            score = SCORE_INF;
+        else if (depth > 2)
+        {
+            uint64_t flips = position.makeMove(sq);
+            score -= 64 * popCount(position.getMoves());
+            position.undoMove(sq, flips);
+        }
+
+        list.addSorted(sq, score);
+    }
+}
+
+static int negamax(SearchContext &context, Position &position,
+                   int depth, int alpha, int beta, int ply)
+{
+    context.nodes++;
+    context.pvLength[ply] = ply;
+
+    if (shouldStop(context))
+        return 0;
+
+    uint64_t moves = position.getMoves();
+    if (!moves)
+    {
+        if (!generateMoves(position.getOpponent(), position.getPlayer()))
+            return finalScore(position);
+
+        position.passMove();
+        int score = -negamax(context, position, depth, -beta, -alpha, ply + 1);
+        position.passMove();
+        context.pvLength[ply] = ply;
+        return score;
+    }
+
+    if (depth <= 0 || ply >= MAX_PLY - 1)
+        return evaluate(position, context.eval);
+
+    TTData ttData;
+    int ttMove = TT_NO_MOVE;
+    context.ttProbes++;
+    if (ttProbe(position.hash, ttData))
+    {
+        context.ttHits++;
+        ttMove = ttData.move;
+
+        if (ttData.depth >= depth &&
+            ((ttData.bound == TT_BOUND_EXACT) ||
+             (ttData.bound == TT_BOUND_LOWER && ttData.score >= beta) ||
+             (ttData.bound == TT_BOUND_UPPER && ttData.score <= alpha)))
+            return ttData.score;
+    }
+
+    MoveList list;
+    orderMoves(position, moves, list, depth, ttMove);
+    int bestScore = -SCORE_INF;
+    int bestMove = TT_NO_MOVE;
+    int originalAlpha = alpha;
+
+    for (int i = 0; i < list.size(); i++)
+    {
+        int sq = list[i];
+        Player player = position.currentPlayer;
+        uint64_t flips = position.makeMove(sq);
+        evalMakeMove(context.eval, player, sq, flips);
+        int score;
+
+        if (i == 0)
+            score = -negamax(context, position, depth - 1, -beta, -alpha, ply + 1);
+        else
+        {
+            // Principal variation search: null window, re-search on fail high
+            score = -negamax(context, position, depth - 1, -alpha - 1, -alpha, ply + 1);
+            if (score > alpha && score < beta)
+                score = -negamax(context, position, depth - 1, -beta, -alpha, ply + 1);
+        }
+
+        position.undoMove(sq, flips);
+        evalUndoMove(context.eval, player, sq, flips);
+
+        if (context.stop)
+            return 0;
+
+        if (score > bestScore)
+        {
+            bestScore = score;
+            bestMove = sq;
+
+            if (score > alpha)
+            {
+                alpha = score;
+
+                context.pv[ply][ply] = sq;
+                for (int j = ply + 1; j < context.pvLength[ply + 1]; j++)
+                    context.pv[ply][j] = context.pv[ply + 1][j];
+                context.pvLength[ply] = context.pvLength[ply + 1];
+
+                if (alpha >= beta)
+                {
+                    countCutoff(context, i);
+                    break;
+                }
+            }
+        }
+    }
+
+    TTBound bound = (bestScore <= originalAlpha) ? TT_BOUND_UPPER
+                    : (bestScore >= beta)        ? TT_BOUND_LOWER
+                                                 : TT_BOUND_EXACT;
+    ttStore(position.hash, depth, bestScore, bound, bestMove);
+
+    return bestScore;
+}
+
+/**
+ * @brief Searches the root moves at a fixed depth.
+ *
+ * @return The best score; the best move is moved to the front of the list.
+ */
+static int searchRoot(SearchContext &context, Position &position,
+                      MoveList &list, int depth, int alpha, int beta)
+{
+    int bestScore = -SCORE_INF;
+
+    context.nodes++;
+    context.pvLength[0] = 0;
+
+    for (int i = 0; i < list.size(); i++)
+    {
+        int sq = list[i];
+        Player player = position.currentPlayer;
+        uint64_t flips = position.makeMove(sq);
+        evalMakeMove(context.eval, player, sq, flips);
+        int score;
+
+        if (i == 0)
+            score = -negamax(context, position, depth - 1, -beta, -alpha, 1);
+        else
+        {
+            score = -negamax(context, position, depth - 1, -alpha - 1, -alpha, 1);
+            if (score > alpha && score < beta)
+                score = -negamax(context, position, depth - 1, -beta, -alpha, 1);
+        }
+
+        position.undoMove(sq, flips);
+        evalUndoMove(context.eval, player, sq, flips);
+
+        if (context.stop)
+            break;
+
+        if (score > bestScore)
+        {
+            bestScore = score;
+
+            if (score > alpha)
+            {
+                alpha = score;
+
+                // Move to front so the next iteration searches it first.
+                // Fail-low scores are only upper bounds, so they never
+                // reorder the list
+                list.moveToFront(i);
+
+                context.pv[0][0] = sq;
+                for (int j = 1; j < context.pvLength[1]; j++)
+                    context.pv[0][j] = context.pv[1][j];
+                context.pvLength[0] = context.pvLength[1];
+
+                if (alpha >= beta)
+                {
+                    countCutoff(context, i);
+                    break;
+                }
+            }
+        }
+    }
+
+    return bestScore;
+}
+
+/**
+ * @brief Persistent pool of helper search threads (Lazy SMP), so threads
+ * are not spawned for every move.
+ */
+struct SearchPool
+{
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::condition_variable finished;
+    std::function<void(int)> job;
+    uint64_t generation = 0;
+    int running = 0;
+    bool quit = false;
+
+    ~SearchPool()
+    {
+        resize(0);
+    }
+
+    // Sets the number of helper threads (thread indices 1..count)
+    void resize(int count)
+    {
+        if (count == (int)workers.size())
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wakeUp.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+        workers.clear();
+
+        quit = false;
+        for (int i = 0; i < count; i++)
+            workers.push_back(std::thread(&SearchPool::workerLoop, this, i + 1, generation));
+    }
+
+    // Runs job(threadIndex) on every helper thread
+    void start(std::function<void(int)> newJob)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = newJob;
+            running = (int)workers.size();
+            generation++;
+        }
+        wakeUp.notify_all();
+    }
+
+    // Waits until every helper thread has finished its job
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this] { return running == 0; });
+    }
+
+    void workerLoop(int threadIndex, uint64_t lastGeneration)
+    {
+        for (;;)
+        {
+            std::function<void(int)> currentJob;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeUp.wait(lock, [&] { return quit || generation != lastGeneration; });
+                if (quit)
+                    return;
+                lastGeneration = generation;
+                currentJob = job;
+            }
+
+            currentJob(threadIndex);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                running--;
+            }
+            finished.notify_all();
+        }
+    }
+};
+
+static SearchPool searchPool;
+static std::mutex searchPoolMutex;
+
+// Per calling thread, so that independent searches can run at once
+static thread_local std::vector<std::unique_ptr<SearchContext>> searchContexts;
+
+/**
+ * @brief Makes the calling thread use a search's transposition table until
+ * the search returns.
+ */
+struct ThreadTableScope
+{
+    TTTable *previous;
+
+    ThreadTableScope(TTTable *table) : previous(ttGetThreadTable())
+    {
+        if (table)
+            ttSetThreadTable(table);
+    }
+
+    ~ThreadTableScope()
+    {
+        ttSetThreadTable(previous);
+    }
+};
+
+/**
+ * @brief Iterative deepening for one search thread. Helper threads start
+ * one ply deeper on odd indices so they fill the shared transposition table
+ * ahead of the main thread. onIteration, if set, is called after each
+ * completed iteration.
+ */
+static void iterativeDeepening(SearchContext &context, Position position,
+                               int maxDepth, SearchResult &result,
+                               const std::function<void()> &onIteration = nullptr)
 {
-    // To-do: your code goes here...
+    MoveList list;
+    orderMoves(position, position.getMoves(), list, 3);
+
+    result.bestMove = list.getSquare(0);
+    initEvalState(context.eval, position, context.evalWeights);
+
+    int score = 0;
+    int firstDepth = 1 + (context.threadIndex & 1);
+    for (int depth = firstDepth; depth <= maxDepth; depth++)
+    {
+        int window = ASPIRATION_WINDOW;
+        int alpha = (depth > firstDepth) ? score - window : -SCORE_INF;
+        int beta = (depth > firstDepth) ? score + window : SCORE_INF;
+        int iterationScore;
+
+        // Aspiration window: widen and re-search on failure
+        for (;;)
+        {
+            iterationScore = searchRoot(context, position, list, depth, alpha, beta);
+            if (context.stop)
+                break;
 
+            if (iterationScore <= alpha)
+                alpha = (alpha - window <= -SCORE_INF) ? -SCORE_INF : alpha - window;
+            else if (iterationScore >= beta)
+                beta = (beta + window >= SCORE_INF) ? SCORE_INF : beta + window;
+            else
+                break;
 
+            window *= 2;
+        }
+
+        // list[0] only changes on a fully searched improvement, so it is
+        // safe to keep even if the iteration was interrupted
+        result.bestMove = list.getSquare(0);
+
+        if (context.stop)
+            break;
+
+        score = iterationScore;
+        result.score = score;
+        result.depth = depth;
+        result.pv.clear();
+        for (int j = 0; j < context.pvLength[0]; j++)
+            result.pv.push_back(squareFromIndex(context.pv[0][j]));
+
+        context.liveNodes.store(context.nodes, std::memory_order_relaxed);
+
+        if (!context.threadIndex)
+            LOG_DEBUG("depth %d: %c%d score %+d, %llu nodes", depth,
+                      'a' + result.bestMove.y, result.bestMove.x + 1, score,
+                      (unsigned long long)context.nodes);
+        if (onIteration)
+            onIteration();
+
+        // Don't start an iteration that is unlikely to finish
+        double elapsed = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - context.start)
+                             .count();
+        double maxTime = context.maxTime->load(std::memory_order_relaxed);
+        if (maxTime > 0 && elapsed > maxTime / 2)
+            break;
+    }
+}
+
+/**
+ * @brief Exact endgame solve on the main thread, polled like the midgame
+ * search. If result already holds a midgame search and the solve is cut
+ * short, the midgame move is kept.
+ */
+static void runEndgameSolve(const Position &position, const SearchLimits &limits,
+                            SearchContext &context, SearchResult &result,
+                            std::chrono::steady_clock::time_point start)
+{
+    int empties = 64 - popCount(position.black | position.white);
+    uint64_t midgameNodes = context.nodes;
+    bool hasFallback = (result.depth > 0);
+
+    EndgameResult endgameResult;
+    solveEndgame(position, limits.endgameMode, [&](uint64_t nodes) {
+        context.nodes = midgameNodes + nodes;
+        return shouldStop(context, true);
+    }, endgameResult);
+
+    if (endgameResult.complete || !hasFallback)
+    {
+        result.bestMove = squareFromIndex(endgameResult.bestMove);
+        result.score = endgameResult.score;
+        result.depth = endgameResult.complete ? empties : 0;
+        result.pv.clear();
+        for (int sq : endgameResult.pv)
+            result.pv.push_back(squareFromIndex(sq));
+    }
+
+    result.nodes += endgameResult.nodes;
+    if (result.threadNodes.empty())
+        result.threadNodes.push_back(0);
+    result.threadNodes[0] += endgameResult.nodes;
+    result.stats.endgame = true;
+    LOG_DEBUG("endgame: %d empties, score %+d%s, %llu nodes", empties, endgameResult.score,
+              endgameResult.complete ? "" : " (incomplete)",
+              (unsigned long long)endgameResult.nodes);
+    result.time = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+}
+
+static SearchResult runSearch(GameModel &model, const SearchLimits &limits)
+{
+    SearchResult result;
+    Position position = getPosition(model);
+
+    if (!position.getMoves())
+        return result;
+
+    BookMove bookMove;
+    if (limits.useBook && getBookMove(position, limits.bookRandomness, bookMove))
+    {
+        result.bestMove = squareFromIndex(bookMove.move);
+        result.score = bookMove.score;
+        result.depth = bookMove.depth;
+        result.pv.push_back(result.bestMove);
+        result.stats.book = true;
+        LOG_DEBUG("book move: %c%d score %+d", 'a' + result.bestMove.y,
+                  result.bestMove.x + 1, result.score);
+        return result;
+    }
+
+    int threads = (limits.threads > 1) ? limits.threads : 1;
+    int empties = 64 - popCount(position.black | position.white);
+    int maxDepth = limits.maxDepth > 0 ? limits.maxDepth : MAX_PLY;
+    if (maxDepth > empties)
+        maxDepth = empties;
+
+    std::atomic<bool> stop(false);
+    std::atomic<double> maxTime(limits.maxTime);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    ThreadTableScope tableScope(limits.tt);
+    TTTable *table = ttGetThreadTable();
+
+    // Helper threads see this thread's contexts through the reference
+    auto &contexts = searchContexts;
+    while ((int)contexts.size() < threads)
+        contexts.push_back(std::unique_ptr<SearchContext>(new SearchContext()));
+    for (int i = 0; i < threads; i++)
+    {
+        SearchContext &context = *contexts[i];
+        context.threadIndex = i;
+        context.nodes = 0;
+        context.maxNodes = limits.maxNodes;
+        context.maxTime = limits.timeLimit ? limits.timeLimit : &maxTime;
+        context.start = start;
+        context.stop = false;
+        context.sharedStop = &stop;
+        context.externalStop = limits.stop;
+        context.evalWeights = limits.evalWeights;
+
+        context.ttProbes = 0;
+        context.ttHits = 0;
+        context.betaCutoffs = 0;
+        for (int j = 0; j < SEARCH_CUTOFF_SLOTS; j++)
+            context.cutoffsAt[j] = 0;
+        context.liveNodes.store(0, std::memory_order_relaxed);
+    }
+
+    ttNewSearch();
+
+    // Only without a depth limit short of the end of the game
+    bool solve = (empties <= limits.endgameEmpties && maxDepth >= empties);
+    bool interruptible = (limits.maxTime > 0 || limits.timeLimit || limits.maxNodes ||
+                          limits.stop);
+    if (solve && !interruptible)
+    {
+        runEndgameSolve(position, limits, *contexts[0], result, start);
+        return result;
+    }
+    if (solve && maxDepth > ENDGAME_FALLBACK_DEPTH)
+        maxDepth = ENDGAME_FALLBACK_DEPTH;
+
+    // Lazy SMP: helpers search the same root and share only the table
+    std::vector<SearchResult> helperResults(threads);
+    std::unique_lock<std::mutex> poolLock(searchPoolMutex, std::defer_lock);
+    if (threads > 1)
+    {
+        poolLock.lock();
+        searchPool.resize(threads - 1);
+        searchPool.start([&](int threadIndex) {
+            ttSetThreadTable(table);
+            iterativeDeepening(*contexts[threadIndex], position, maxDepth,
+                               helperResults[threadIndex]);
+        });
+    }
+
+    // Progress as of each main thread iteration
+    std::function<void()> onIteration;
+    if (limits.progress)
+        onIteration = [&]() {
+            SearchStats stats = result.stats;
+            stats.depth = result.depth;
+            stats.threads = threads;
+            stats.time = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+            stats.timeBudget = contexts[0]->maxTime->load();
+            for (int i = 0; i < threads; i++)
+                stats.nodes += contexts[i]->liveNodes.load(std::memory_order_relaxed);
+            stats.nodesPerSecond = (stats.time > 0) ? stats.nodes / stats.time : 0;
+            stats.branchingFactor = getBranchingFactor(contexts[0]->nodes, stats.depth);
+            addStats(stats, *contexts[0]);
+            limits.progress(stats);
+        };
+
+    iterativeDeepening(*contexts[0], position, maxDepth, result, onIteration);
+
+    stop.store(true);
+    if (threads > 1)
+        searchPool.wait();
+
+    result.nodes = 0;
+    result.threadNodes.clear();
+    for (int i = 0; i < threads; i++)
+    {
+        result.threadNodes.push_back(contexts[i]->nodes);
+        result.nodes += contexts[i]->nodes;
+        addStats(result.stats, *contexts[i]);
+    }
+    result.stats.threads = threads;
+
+    // The solve gets what is left of the limits
+    if (solve && !contexts[0]->stop)
+    {
+        stop.store(false);
+        runEndgameSolve(position, limits, *contexts[0], result, start);
+        return result;
+    }
+
+    result.time = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+
+    return result;
+}
+static std::mutex statsFileMutex;
+static FILE *statsFile = nullptr;
+
+static struct SearchStatsInit
+{
+    SearchStatsInit()
+    {
+        const char *path = getenv(SEARCH_STATS_ENV);
+        if (path && *path && !setSearchStatsFile(path))
+            LOG_WARN("search stats: cannot open %s", path);
+    }
+} searchStatsInit;
+
+SearchResult searchBestMove(GameModel &model, const SearchLimits &limits)
+{
+    SearchResult result = runSearch(model, limits);
+
+    SearchStats &stats = result.stats;
+    stats.depth = result.depth;
+    stats.nodes = result.nodes;
+    stats.time = result.time;
+    stats.timeBudget = limits.timeLimit ? limits.timeLimit->load() : limits.maxTime;
+    stats.nodesPerSecond = (result.time > 0) ? result.nodes / result.time : 0;
+    if (!result.threadNodes.empty())
+        stats.branchingFactor = getBranchingFactor(result.threadNodes[0], stats.depth);
+
+    std::lock_guard<std::mutex> lock(statsFileMutex);
+    if (statsFile && isSquareValid(result.bestMove))
+    {
+        fprintf(statsFile, "%s\n", formatSearchStats(result).c_str());
+        fflush(statsFile);
+    }
+
+    return result;
+}
+
+std::string formatSearchStats(const SearchResult &result)
+{
+    const SearchStats &stats = result.stats;
+    char buffer[1024];
+    std::string s;
+
+    snprintf(buffer, sizeof(buffer),
+             "{\"move\": \"%c%d\", \"score\": %d, \"depth\": %d, \"nodes\": %llu, "
+             "\"time\": %.4f, \"time_budget\": %.4f, \"nps\": %.0f, \"ebf\": %.3f, "
+             "\"threads\": %d, \"tt_probes\": %llu, \"tt_hits\": %llu, "
+             "\"tt_hit_rate\": %.4f, \"beta_cutoffs\": %llu, \"cutoffs_at\": [",
+             'a' + result.bestMove.y, result.bestMove.x + 1, result.score, stats.depth,
+             (unsigned long long)stats.nodes, stats.time, stats.timeBudget,
+             stats.nodesPerSecond, stats.branchingFactor, stats.threads,
+             (unsigned long long)stats.ttProbes, (unsigned long long)stats.ttHits,
+             stats.ttProbes ? (double)stats.ttHits / stats.ttProbes : 0.0,
+             (unsigned long long)stats.betaCutoffs);
+    s = buffer;
+
+    for (int i = 0; i < SEARCH_CUTOFF_SLOTS; i++)
+    {
+        snprintf(buffer, sizeof(buffer), "%s%llu", i ? ", " : "",
+                 (unsigned long long)stats.cutoffsAt[i]);
+        s += buffer;
+    }
+
+    s += "], \"pv\": \"";
+    for (const Square &square : result.pv)
+    {
+        snprintf(buffer, sizeof(buffer), "%c%d", 'a' + square.y, square.x + 1);
+        s += buffer;
+    }
+
+    snprintf(buffer, sizeof(buffer), "\", \"book\": %s, \"endgame\": %s}",
+             stats.book ? "true" : "false", stats.endgame ? "true" : "false");
+    s += buffer;
+
+    return s;
+}
+
+bool setSearchStatsFile(const char *path)
+{
+    std::lock_guard<std::mutex> lock(statsFileMutex);
+
+    if (statsFile)
+        fclose(statsFile);
+    statsFile = path ? fopen(path, "a") : nullptr;
+
+    return !path || statsFile;
+}
+
+static std::future<SearchResult> asyncSearch;
+static std::atomic<bool> asyncStop(false);
+static std::atomic<double> asyncTimeLimit(0);
+static std::chrono::steady_clock::time_point asyncStart;
+
+// Pondering state
+static std::vector<Square> lastPV;
+static bool pondering = false;
+static int ponderPrediction = TT_NO_MOVE;
+static uint64_t ponderHash = 0;
+static uint64_t ponderAttemptHash = 0;
+static PonderStats ponderStats;
+
+// Progress of the background search
+static std::mutex progressMutex;
+static SearchStats asyncProgress;
+
+static void startAsync(GameModel &model, const SearchLimits &limits, double maxTime)
+{
+    cancelSearch();
+
+    GameModel snapshot = model;
+    SearchLimits asyncLimits = limits;
+    asyncLimits.stop = &asyncStop;
+    asyncLimits.timeLimit = &asyncTimeLimit;
+    asyncLimits.progress = [](const SearchStats &stats) {
+        std::lock_guard<std::mutex> lock(progressMutex);
+        asyncProgress = stats;
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(progressMutex);
+        asyncProgress = SearchStats();
+    }
+
+    asyncStop = false;
+    asyncTimeLimit = maxTime;
+    asyncStart = std::chrono::steady_clock::now();
+    asyncSearch = std::async(std::launch::async, [snapshot, asyncLimits]() mutable {
+        return searchBestMove(snapshot, asyncLimits);
+    });
+}
+
+void startSearchAsync(GameModel &model, const SearchLimits &limits)
+{
+    startAsync(model, limits, limits.maxTime);
+}
+
+bool isSearchPending()
+{
+    return asyncSearch.valid();
+}
+
+bool getSearchProgress(SearchStats &stats)
+{
+    if (!asyncSearch.valid())
+        return false;
+
+    std::lock_guard<std::mutex> lock(progressMutex);
+    stats = asyncProgress;
+    return true;
+}
+
+bool pollSearch(SearchResult &result)
+{
+    if (!asyncSearch.valid() ||
+        asyncSearch.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return false;
+
+    result = asyncSearch.get();
+
+    // The PV is from the last completed iteration; an interrupted one may
+    // have changed the best move since
+    lastPV.clear();
+    if (!result.pv.empty() && result.pv[0].index == result.bestMove.index)
+        lastPV = result.pv;
+    return true;
+}
+
+void cancelSearch()
+{
+    pondering = false;
+
+    if (!asyncSearch.valid())
+        return;
+
+    asyncStop = true;
+    asyncSearch.wait();
+    asyncSearch = std::future<SearchResult>();
+}
+
+void startPondering(GameModel &model, const SearchLimits &limits)
+{
+    if (model.gameOver || pondering || isSearchPending() ||
+        model.hash == ponderAttemptHash)
+        return;
+    ponderAttemptHash = model.hash;
+
+    Position position = getPosition(model);
+    uint64_t moves = position.getMoves();
+    if (!moves)
+        return;
+
+    // Predicted reply: second move of the last principal variation, else
+    // the first ordered move (table move first), without searching on the
+    // calling thread
+    int prediction = TT_NO_MOVE;
+    if (lastPV.size() >= 2 && (moves & (1ULL << lastPV[1].index)))
+        prediction = (int)lastPV[1].index;
+    else
+    {
+        int ttMove = TT_NO_MOVE;
+        TTData ttData;
+        if (ttProbe(position.hash, ttData))
+            ttMove = ttData.move;
+
+        MoveList list;
+        orderMoves(position, moves, list, 3, ttMove);
+        prediction = list[0];
+    }
+
+    GameModel predicted = model;
+    Square square = {prediction / BOARD_SIZE, prediction % BOARD_SIZE, (uint64_t)prediction};
+    playMove(predicted, square);
+    if (predicted.gameOver || predicted.currentPlayer == model.currentPlayer)
+        return;
+
+    // No time limit until the human moves
+    startAsync(predicted, limits, 0);
+
+    pondering = true;
+    ponderPrediction = prediction;
+    ponderHash = predicted.hash;
+}
+
+bool isPondering()
+{
+    return pondering;
+}
+
+void ponderMove(GameModel &model, Square move, const SearchLimits &limits)
+{
+    if (!pondering)
+        return;
+
+    if ((int)(move.x * BOARD_SIZE + move.y) == ponderPrediction &&
+        model.hash == ponderHash)
+    {
+        // Ponder hit: keep searching, now with the normal budget on top of
+        // the time already spent
+        double elapsed = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - asyncStart)
+                             .count();
+
+        ponderStats.hits++;
+        ponderStats.ponderTime += elapsed;
+        asyncTimeLimit = (limits.maxTime > 0) ? elapsed + limits.maxTime : 0;
+        pondering = false;
+    }
+    else
+    {
+        ponderStats.misses++;
+        cancelSearch();
+    }
+}
+
+void resetPondering()
+{
+    cancelSearch();
+
+    lastPV.clear();
+    ponderPrediction = TT_NO_MOVE;
+    ponderHash = 0;
+    ponderAttemptHash = 0;
+}
+
+PonderStats getPonderStats()
+{
+    return ponderStats;
+}
+
+Square getBestMove(GameModel &model, SearchStats *stats)
+{
+    SearchLimits limits;
+    limits.maxTime = 1.0;
 
-    // +++ TEST
-    // Returns a random valid move...
-    Moves validMoves;
-    getValidMoves(model, validMoves, model.black, model.white);
-    int index = rand() % validMoves.size();
+    SearchResult result = searchBestMove(model, limits);
+    if (stats)
+        *stats = result.stats;
 
-    return validMoves[index];
-    // --- TEST
+    return result.bestMove;
 }
@@ -8,13 +8,246 @@
 #ifndef AI_H
 #define AI_H
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
 #include "model.h"
+#include "eval.h"
+#include "endgame.h"
+#include "tt.h"
+
+// Search scores (SCORE_DISC per disc), from the side to move's point of view
+#define SCORE_INF 32000
+
+// Beta cutoff histogram: cutoffs by move number, the last slot counts the rest
+#define SEARCH_CUTOFF_SLOTS 8
+
+// Appends one JSON line per search to this file, if set
+#define SEARCH_STATS_ENV "REVERSI_SEARCH_STATS"
+
+/**
+ * @brief Search statistics, counted per thread and summed after the search.
+ */
+struct SearchStats
+{
+    int depth = 0;
+    int threads = 1;
+    uint64_t nodes = 0;
+    double time = 0;
+    double timeBudget = 0; // 0: no time limit
+    double nodesPerSecond = 0;
+
+    // Effective branching factor: main thread nodes ^ (1 / depth)
+    double branchingFactor = 0;
+
+    uint64_t ttProbes = 0;
+    uint64_t ttHits = 0;
+
+    uint64_t betaCutoffs = 0;
+    uint64_t cutoffsAt[SEARCH_CUTOFF_SLOTS] = {0};
+
+    bool book = false;
+    bool endgame = false;
+};
+
+/**
+ * @brief Limits for a search. A zero value means "no limit".
+ */
+struct SearchLimits
+{
+    int maxDepth = 0;
+    double maxTime = 0;
+    uint64_t maxNodes = 0;
+
+    // Search threads (Lazy SMP over the shared transposition table)
+    int threads = 1;
+
+    // Optional external stop request, polled during the search
+    std::atomic<bool> *stop = nullptr;
+
+    // Optional time limit that may change during the search (pondering);
+    // overrides maxTime
+    const std::atomic<double> *timeLimit = nullptr;
+
+    // Opening book: play book moves scoring within bookRandomness
+    // (SCORE_DISC per disc) of the best one, picked at random
+    bool useBook = true;
+    int bookRandomness = 0;
+
+    // Exact endgame solve at this many empty squares or fewer (0: never),
+    // unless maxDepth stops short of the end of the game. Under a time, node
+    // or stop limit a shallow midgame search runs first, and its move is
+    // played if the solve does not finish
+    int endgameEmpties = ENDGAME_DEFAULT_EMPTIES;
+    EndgameMode endgameMode = ENDGAME_EXACT;
+
+    // Optional private transposition table (see ttCreate) and evaluation
+    // weights, so that independent searches can run on several threads at
+    // once; by default the shared table and the current weights
+    TTTable *tt = nullptr;
+    const int16_t *evalWeights = nullptr;
+
+    // Optional progress report, called by the searching thread after each
+    // iteration. Nodes are those of all threads so far; the other counters
+    // only the main thread's
+    std::function<void(const SearchStats &)> progress;
+};
+
+/**
+ * @brief The outcome of a search.
+ */
+struct SearchResult
+{
+    Square bestMove = GAME_INVALID_SQUARE;
+    int score = 0;
+    int depth = 0;
+    uint64_t nodes = 0;
+    double time = 0;
+    std::vector<Square> pv;
+
+    // Nodes searched by each thread (index 0 is the main thread)
+    std::vector<uint64_t> threadNodes;
+
+    SearchStats stats;
+};
+
+/**
+ * @brief Searches a position with iterative-deepening negamax (alpha-beta,
+ * principal variation search and aspiration windows), or solves it with the
+ * endgame solver from limits.endgameEmpties empties on.
+ *
+ * Several threads may search at once if each one uses its own limits.tt;
+ * multi-threaded searches take turns using the helper threads.
+ *
+ * @param model The game model. The current player must have a valid move.
+ * @param limits The depth, time and node budget.
+ * @return The best move found in the last completed iteration.
+ */
+SearchResult searchBestMove(GameModel &model, const SearchLimits &limits);
+
+/**
+ * @brief Formats a search result and its statistics as one line of JSON.
+ *
+ * @param result The search result.
+ * @return The JSON object, without a line break.
+ */
+std::string formatSearchStats(const SearchResult &result);
+
+/**
+ * @brief Appends every search's statistics to a JSON-lines file. Set at
+ * startup from $REVERSI_SEARCH_STATS.
+ *
+ * @param path The file path, or nullptr to stop.
+ * @return Whether the file could be opened.
+ */
+bool setSearchStatsFile(const char *path);
+
+/**
+ * @brief Pondering statistics.
+ */
+struct PonderStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    // Search time gained on ponder hits, in seconds
+    double ponderTime = 0;
+};
+
+/**
+ * @brief Starts searching a snapshot of the model on a background thread,
+ * cancelling any search already running.
+ *
+ * Only one search (synchronous or background) may run at a time.
+ *
+ * @param model The game model (copied; it may change after the call).
+ * @param limits The depth, time and node budget.
+ */
+void startSearchAsync(GameModel &model, const SearchLimits &limits);
+
+/**
+ * @brief Indicates whether a background search was started and its result
+ * has not been collected yet.
+ *
+ * @return true or false.
+ */
+bool isSearchPending();
+
+/**
+ * @brief Returns the statistics of the running background search, as of
+ * its last completed iteration.
+ *
+ * @param stats Receives the statistics.
+ * @return Whether a background search is running.
+ */
+bool getSearchProgress(SearchStats &stats);
+
+/**
+ * @brief Collects the background search result without blocking.
+ *
+ * @param result Receives the result when the search has finished.
+ * @return Whether the result was ready.
+ */
+bool pollSearch(SearchResult &result);
+
+/**
+ * @brief Stops the background search (if any) and discards its result.
+ */
+void cancelSearch();
+
+/**
+ * @brief Starts pondering while the opponent (human) is to move: predicts
+ * the reply and searches the resulting position in the background without a
+ * time limit. Does nothing if already pondering or attempted for this
+ * position.
+ *
+ * @param model The game model, with the opponent to move.
+ * @param limits The limits for the AI's own move.
+ */
+void startPondering(GameModel &model, const SearchLimits &limits);
+
+/**
+ * @brief Indicates whether a ponder search is running.
+ *
+ * @return true or false.
+ */
+bool isPondering();
+
+/**
+ * @brief Reports the opponent's move to the ponder search. On a ponder hit
+ * the background search keeps its tree and table state and continues with
+ * limits.maxTime; collect it with pollSearch. On a miss it is cancelled.
+ *
+ * @param model The game model, after the move was played.
+ * @param move The move played.
+ * @param limits The limits for the AI's own move.
+ */
+void ponderMove(GameModel &model, Square move, const SearchLimits &limits);
+
+/**
+ * @brief Cancels the background search and forgets what earlier moves left
+ * for pondering (last principal variation, last ponder attempt). Call it
+ * when a new game starts.
+ */
+void resetPondering();
+
+/**
+ * @brief Returns the pondering statistics.
+ *
+ * @return The statistics.
+ */
+PonderStats getPonderStats();
 
 /**
  * @brief Returns the best move for a certain position.
  *
+ * @param model The game model.
+ * @param stats Optionally receives the search statistics.
  * @return The best move.
  */
-Square getBestMove(GameModel &model);
+Square getBestMove(GameModel &model, SearchStats *stats = nullptr);
 
 #endif
@@ -0,0 +1,356 @@
+/**
+ * @brief Microbenchmarks for the core bitboard kernels
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "bitops.h"
+#include "model.h"
+#include "eval.h"
+#include "symmetry.h"
+
+#define CORPUS_SEED 20240601
+#define CORPUS_GAMES 64
+
+/**
+ * @brief A move in a corpus position, for the per-move kernels.
+ */
+struct CorpusMove
+{
+    Position position;
+    int sq;
+};
+
+struct Corpus
+{
+    std::string name;
+    std::vector<Position> positions;
+    std::vector<GameModel> models;
+    std::vector<CorpusMove> moves;
+};
+
+struct BenchResult
+{
+    std::string kernel;
+    std::string corpus;
+    uint64_t opsPerRun;
+    int runs;
+    double nsPerOp;
+    double stddev;
+    double minNsPerOp;
+};
+
+// Keeps the compiler from discarding kernel results
+static volatile uint64_t sink;
+
+/**
+ * @brief Fixed pseudo-random generator (xorshift64), so the corpora are the
+ * same on every platform and do not depend on the engine's play.
+ */
+static uint64_t nextRandom(uint64_t &state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+/**
+ * @brief Builds the midgame and endgame corpora from random games with a
+ * fixed seed: the corpora are identical between runs and builds.
+ */
+static void buildCorpora(Corpus &midgame, Corpus &endgame)
+{
+    midgame.name = "midgame";
+    endgame.name = "endgame";
+
+    uint64_t state = CORPUS_SEED;
+
+    for (int game = 0; game < CORPUS_GAMES; game++)
+    {
+        GameModel model;
+        initModel(model);
+        model.humanPlayer = PLAYER_BLACK;
+        startModel(model);
+
+        while (!model.gameOver)
+        {
+            int discs = getScore(model, PLAYER_BLACK) + getScore(model, PLAYER_WHITE);
+            Corpus *corpus = NULL;
+            if (discs >= 20 && discs <= 40)
+                corpus = &midgame;
+            else if (discs >= 46)
+                corpus = &endgame;
+
+            if (corpus)
+            {
+                Position position = getPosition(model);
+                corpus->positions.push_back(position);
+                corpus->models.push_back(model);
+
+                for (uint64_t moves = position.getMoves(); moves;)
+                {
+                    CorpusMove move;
+                    move.position = position;
+                    move.sq = popLowestSquare(moves);
+                    corpus->moves.push_back(move);
+                }
+            }
+
+            MoveList validMoves;
+            getValidMoves(model, validMoves, model.black, model.white);
+            playMove(model, validMoves.getSquare(nextRandom(state) % validMoves.size()));
+        }
+    }
+}
+
+/**
+ * @brief Times `kernel` over the corpus: `runs` timed runs, each repeated
+ * until it lasts at least `minTime` seconds.
+ */
+template <class Kernel>
+static BenchResult runBench(const std::string &name, const Corpus &corpus,
+                            uint64_t opsPerPass, int runs, double minTime,
+                            Kernel kernel)
+{
+    BenchResult result;
+    result.kernel = name;
+    result.corpus = corpus.name;
+    result.runs = runs;
+
+    // Calibrate the number of passes per run
+    int passes = 1;
+    for (;;)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < passes; i++)
+            kernel();
+        double elapsed = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+        if (elapsed >= minTime || passes >= (1 << 24))
+            break;
+        passes *= 2;
+    }
+    result.opsPerRun = opsPerPass * passes;
+
+    std::vector<double> samples;
+    for (int run = 0; run < runs; run++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < passes; i++)
+            kernel();
+        double elapsed = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+        samples.push_back(elapsed * 1e9 / result.opsPerRun);
+    }
+
+    double sum = 0;
+    result.minNsPerOp = samples[0];
+    for (double sample : samples)
+    {
+        sum += sample;
+        if (sample < result.minNsPerOp)
+            result.minNsPerOp = sample;
+    }
+    result.nsPerOp = sum / runs;
+
+    double variance = 0;
+    for (double sample : samples)
+        variance += (sample - result.nsPerOp) * (sample - result.nsPerOp);
+    result.stddev = (runs > 1) ? sqrt(variance / (runs - 1)) : 0;
+
+    return result;
+}
+
+static void benchCorpus(Corpus &corpus, int runs, double minTime,
+                        std::vector<BenchResult> &results)
+{
+    const std::vector<Position> &positions = corpus.positions;
+    const std::vector<CorpusMove> &moves = corpus.moves;
+
+    // Move generation, once per kernel the CPU supports
+    MoveGenerator defaultGenerator = getMoveGenerator();
+    std::vector<uint64_t> me, opp, batchMoves(positions.size());
+    for (const Position &p : positions)
+    {
+        me.push_back(p.getPlayer());
+        opp.push_back(p.getOpponent());
+    }
+
+    for (int g = MOVEGEN_SCALAR; g <= MOVEGEN_AVX2; g++)
+    {
+        if (!setMoveGenerator((MoveGenerator)g))
+            continue;
+        std::string suffix = std::string("/") + getMoveGeneratorName((MoveGenerator)g);
+
+        results.push_back(runBench("generateMoves" + suffix, corpus, positions.size(), runs, minTime, [&]() {
+            uint64_t x = 0;
+            for (const Position &p : positions)
+                x ^= generateMoves(p.getPlayer(), p.getOpponent());
+            sink = x;
+        }));
+
+        results.push_back(runBench("generateBatch" + suffix, corpus, positions.size(), runs, minTime, [&]() {
+            generateMovesBatch(me.data(), opp.data(), batchMoves.data(), positions.size());
+            sink = batchMoves[0];
+        }));
+
+        results.push_back(runBench("computeFlips" + suffix, corpus, moves.size(), runs, minTime, [&]() {
+            uint64_t x = 0;
+            for (const CorpusMove &m : moves)
+                x ^= computeFlips(m.position.getPlayer(), m.position.getOpponent(), m.sq);
+            sink = x;
+        }));
+    }
+    setMoveGenerator(defaultGenerator);
+
+    results.push_back(runBench("makeUndoMove", corpus, moves.size(), runs, minTime, [&]() {
+        uint64_t x = 0;
+        for (const CorpusMove &m : moves)
+        {
+            Position p = m.position;
+            uint64_t flips = p.makeMove(m.sq);
+            x ^= p.hash;
+            p.undoMove(m.sq, flips);
+            x ^= p.black;
+        }
+        sink = x;
+    }));
+
+    results.push_back(runBench("getScore", corpus, corpus.models.size(), runs, minTime, [&]() {
+        uint64_t x = 0;
+        for (GameModel &model : corpus.models)
+            x += getScore(model, PLAYER_BLACK);
+        sink = x;
+    }));
+
+    results.push_back(runBench("evaluate", corpus, positions.size(), runs, minTime, [&]() {
+        uint64_t x = 0;
+        for (const Position &p : positions)
+            x += evaluate(p);
+        sink = x;
+    }));
+
+    std::vector<int> scores(positions.size());
+    results.push_back(runBench("evaluateBatch", corpus, positions.size(), runs, minTime, [&]() {
+        evaluateBatch(positions.data(), positions.size(), scores.data());
+        sink = scores[0];
+    }));
+
+    // Incremental pattern indices, as the search keeps them
+    std::vector<EvalState> states(moves.size());
+    for (size_t i = 0; i < moves.size(); i++)
+        initEvalState(states[i], moves[i].position);
+
+    results.push_back(runBench("evalMakeUndo", corpus, moves.size(), runs, minTime, [&]() {
+        uint64_t x = 0;
+        for (size_t i = 0; i < moves.size(); i++)
+        {
+            const CorpusMove &m = moves[i];
+            Player player = m.position.currentPlayer;
+            Position p = m.position;
+            uint64_t flips = p.makeMove(m.sq);
+            evalMakeMove(states[i], player, m.sq, flips);
+            x += evaluate(p, states[i]);
+            evalUndoMove(states[i], player, m.sq, flips);
+        }
+        sink = x;
+    }));
+
+    results.push_back(runBench("computeHash", corpus, positions.size(), runs, minTime, [&]() {
+        uint64_t x = 0;
+        for (const Position &p : positions)
+            x ^= computeHash(p.black, p.white, p.currentPlayer);
+        sink = x;
+    }));
+
+    results.push_back(runBench("getFlipHash", corpus, positions.size(), runs, minTime, [&]() {
+        uint64_t x = 0;
+        for (const Position &p : positions)
+            x ^= getFlipHash(p.black);
+        sink = x;
+    }));
+
+    results.push_back(runBench("canonical", corpus, positions.size(), runs, minTime, [&]() {
+        uint64_t x = 0;
+        for (const Position &p : positions)
+        {
+            CanonicalBoard c = canonical(p.black, p.white);
+            x ^= c.black + c.white + c.symmetry;
+        }
+        sink = x;
+    }));
+}
+
+int main(int argc, char *argv[])
+{
+    bool json = false;
+    int runs = 10;
+    double minTime = 0.05;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--json"))
+            json = true;
+        else if (!strcmp(argv[i], "--runs") && i + 1 < argc)
+            runs = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--min-time") && i + 1 < argc)
+            minTime = atof(argv[++i]);
+        else
+        {
+            printf("usage: bench [--json] [--runs N] [--min-time seconds]\n");
+            return 1;
+        }
+    }
+    if (runs < 1)
+        runs = 1;
+
+    Corpus midgame, endgame;
+    buildCorpora(midgame, endgame);
+
+    std::vector<BenchResult> results;
+    benchCorpus(midgame, runs, minTime, results);
+    benchCorpus(endgame, runs, minTime, results);
+
+    if (json)
+    {
+        printf("{\n  \"corpus\": {\"midgame\": %d, \"endgame\": %d},\n  \"results\": [\n",
+               (int)midgame.positions.size(), (int)endgame.positions.size());
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const BenchResult &r = results[i];
+            printf("    {\"kernel\": \"%s\", \"corpus\": \"%s\", \"runs\": %d, "
+                   "\"ops_per_run\": %llu, \"ns_per_op\": %.3f, \"stddev_ns\": %.3f, "
+                   "\"min_ns_per_op\": %.3f, \"ops_per_sec\": %.0f}%s\n",
+                   r.kernel.c_str(), r.corpus.c_str(), r.runs,
+                   (unsigned long long)r.opsPerRun, r.nsPerOp, r.stddev,
+                   r.minNsPerOp, 1e9 / r.nsPerOp,
+                   (i + 1 < results.size()) ? "," : "");
+        }
+        printf("  ]\n}\n");
+    }
+    else
+    {
+        printf("corpus: %d midgame, %d endgame positions\n",
+               (int)midgame.positions.size(), (int)endgame.positions.size());
+        printf("%-20s %-8s %10s %10s %10s %14s\n",
+               "kernel", "corpus", "ns/op", "stddev", "min", "ops/s");
+        for (const BenchResult &r : results)
+            printf("%-20s %-8s %10.2f %10.2f %10.2f %14.0f\n",
+                   r.kernel.c_str(), r.corpus.c_str(), r.nsPerOp, r.stddev,
+                   r.minNsPerOp, 1e9 / r.nsPerOp);
+    }
+
+    return 0;
+}
@@ -0,0 +1,87 @@
+/**
+ * @brief Implements the bit manipulation primitives
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "bitops.h"
+
+static uint64_t extractBitsPortable(uint64_t x, uint64_t mask)
+{
+    uint64_t result = 0;
+
+    for (uint64_t bit = 1; mask; mask &= mask - 1, bit <<= 1)
+        if (x & mask & (0ULL - mask))
+            result |= bit;
+
+    return result;
+}
+
+static uint64_t depositBitsPortable(uint64_t x, uint64_t mask)
+{
+    uint64_t result = 0;
+
+    for (uint64_t bit = 1; mask; mask &= mask - 1, bit <<= 1)
+        if (x & bit)
+            result |= mask & (0ULL - mask);
+
+    return result;
+}
+
+#ifdef REVERSI_X86_64
+REVERSI_TARGET("bmi2") static uint64_t extractBitsHardware(uint64_t x, uint64_t mask)
+{
+    return extractBitsBmi2(x, mask);
+}
+
+REVERSI_TARGET("bmi2") static uint64_t depositBitsHardware(uint64_t x, uint64_t mask)
+{
+    return depositBitsBmi2(x, mask);
+}
+#endif
+
+static uint64_t (*extractBitsKernel)(uint64_t, uint64_t) = extractBitsPortable;
+static uint64_t (*depositBitsKernel)(uint64_t, uint64_t) = depositBitsPortable;
+
+/**
+ * @brief Selects the PEXT/PDEP kernels, and refuses to run a POPCNT build
+ * on a CPU without it.
+ */
+static struct BitopsInit
+{
+    BitopsInit()
+    {
+        const CpuFeatures &features = getCpuFeatures();
+
+#if defined(__POPCNT__) || (defined(_MSC_VER) && defined(__AVX__))
+        if (!features.popcnt)
+        {
+            fprintf(stderr, "this build requires a CPU with POPCNT\n");
+            exit(1);
+        }
+#endif
+
+#ifdef REVERSI_X86_64
+        if (features.fastPext)
+        {
+            extractBitsKernel = extractBitsHardware;
+            depositBitsKernel = depositBitsHardware;
+        }
+#endif
+        (void)features;
+    }
+} bitopsInit;
+
+uint64_t extractBits(uint64_t x, uint64_t mask)
+{
+    return extractBitsKernel(x, mask);
+}
+
+uint64_t depositBits(uint64_t x, uint64_t mask)
+{
+    return depositBitsKernel(x, mask);
+}
@@ -0,0 +1,135 @@
+/**
+ * @brief Implements the bit manipulation primitives
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#ifndef BITOPS_H
+#define BITOPS_H
+
+#include <cstdint>
+
+#include "cpu.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#ifdef REVERSI_X86_64
+#include <immintrin.h>
+#endif
+
+/*
+ * popCount, lowestSquare and highestSquare sit in the hottest loops, where
+ * an indirect call would cost more than the instruction saves, so they are
+ * chosen at compile time. Bit scans are baseline x86-64 (BSF/BSR); POPCNT
+ * is used when the build targets it (REVERSI_NATIVE), and checked against
+ * the CPU at startup. Whole kernels built on PEXT are dispatched at startup
+ * instead (see computePatternIndices).
+ */
+
+/**
+ * @brief Counts the set bits.
+ */
+inline int popCount(uint64_t x)
+{
+#if defined(__POPCNT__) && (defined(__GNUC__) || defined(__clang__))
+    return __builtin_popcountll(x);
+#elif defined(_MSC_VER) && defined(REVERSI_X86_64) && defined(__AVX__)
+    return (int)__popcnt64(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/**
+ * @brief Returns the index of the lowest set bit. `x` must not be 0.
+ */
+inline int lowestSquare(uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#elif defined(_MSC_VER) && defined(REVERSI_X86_64)
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return (int)index;
+#else
+    static const int debruijnIndex[64] = {
+        0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4,
+        62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+        63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+        46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6,
+    };
+    return debruijnIndex[((x & (0ULL - x)) * 0x03F79D71B4CB0A89ULL) >> 58];
+#endif
+}
+
+/**
+ * @brief Returns the index of the highest set bit. `x` must not be 0.
+ */
+inline int highestSquare(uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(x);
+#elif defined(_MSC_VER) && defined(REVERSI_X86_64)
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return (int)index;
+#else
+    x |= x >> 1;
+    x |= x >> 2;
+    x |= x >> 4;
+    x |= x >> 8;
+    x |= x >> 16;
+    x |= x >> 32;
+    return lowestSquare(x ^ (x >> 1));
+#endif
+}
+
+/**
+ * @brief Bit-scan iteration: returns the lowest set bit's index and clears
+ * it. `x` must not be 0.
+ *
+ * for (uint64_t b = moves; b;) { int sq = popLowestSquare(b); ... }
+ */
+inline int popLowestSquare(uint64_t &x)
+{
+    int sq = lowestSquare(x);
+    x &= x - 1;
+    return sq;
+}
+
+/**
+ * @brief Parallel bit extract (PEXT): gathers the bits of `x` selected by
+ * `mask` into the low bits, in ascending order. Uses BMI2 when the CPU has
+ * a fast implementation.
+ */
+uint64_t extractBits(uint64_t x, uint64_t mask);
+
+/**
+ * @brief Parallel bit deposit (PDEP): scatters the low bits of `x` to the
+ * positions set in `mask`, in ascending order. Uses BMI2 when the CPU has
+ * a fast implementation.
+ */
+uint64_t depositBits(uint64_t x, uint64_t mask);
+
+#ifdef REVERSI_X86_64
+/*
+ * Direct BMI2 forms, for kernels compiled with REVERSI_TARGET("bmi2") and
+ * only called when getCpuFeatures().fastPext is set.
+ */
+REVERSI_TARGET("bmi2") inline uint64_t extractBitsBmi2(uint64_t x, uint64_t mask)
+{
+    return _pext_u64(x, mask);
+}
+
+REVERSI_TARGET("bmi2") inline uint64_t depositBitsBmi2(uint64_t x, uint64_t mask)
+{
+    return _pdep_u64(x, mask);
+}
+#endif
+
+#endif
@@ -0,0 +1,221 @@
+/**
+ * @brief Implements the opening book
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+
+#include "book.h"
+#include "log.h"
+#include "mappedfile.h"
+#include "symmetry.h"
+
+static MappedFile bookFile;
+static const BookEntry *bookEntries = nullptr;
+static uint64_t bookEntryCount = 0;
+
+static std::mutex randomMutex;
+static std::mt19937 randomGenerator(std::random_device{}());
+
+static bool isEntryLess(const BookEntry &a, const BookEntry &b)
+{
+    if (a.player != b.player)
+        return a.player < b.player;
+    if (a.opponent != b.opponent)
+        return a.opponent < b.opponent;
+    return a.move < b.move;
+}
+
+bool saveBook(const char *path, std::vector<BookEntry> &entries, std::string &error)
+{
+    std::sort(entries.begin(), entries.end(), isEntryLess);
+
+    BookFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BOOK_FILE_MAGIC, sizeof(header.magic));
+    header.version = BOOK_FILE_VERSION;
+    header.headerSize = sizeof(BookFileHeader);
+    header.entryCount = entries.size();
+    header.checksum = getChecksum(entries.data(), entries.size() * sizeof(BookEntry));
+
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        error = std::string("cannot create ") + path;
+        return false;
+    }
+
+    bool ok = (fwrite(&header, sizeof(header), 1, file) == 1) &&
+              (entries.empty() ||
+               fwrite(entries.data(), sizeof(BookEntry), entries.size(), file) == entries.size());
+    ok = !fclose(file) && ok;
+    if (!ok)
+        error = std::string("cannot write ") + path;
+
+    return ok;
+}
+
+static bool checkHeader(const MappedFile &mappedFile, std::string &error)
+{
+    const BookFileHeader *header = (const BookFileHeader *)mappedFile.data;
+
+    if (mappedFile.size < sizeof(BookFileHeader) ||
+        memcmp(header->magic, BOOK_FILE_MAGIC, sizeof(header->magic)))
+        error = "not a book file";
+    else if (header->version != BOOK_FILE_VERSION)
+        error = "unsupported version " + std::to_string(header->version);
+    else if (header->headerSize != sizeof(BookFileHeader) ||
+             mappedFile.size != sizeof(BookFileHeader) + header->entryCount * sizeof(BookEntry))
+        error = "bad file size";
+    else
+        return true;
+
+    return false;
+}
+
+bool loadBook(const char *path, std::string &error)
+{
+    MappedFile mappedFile;
+    if (!mapFile(path, mappedFile))
+    {
+        error = std::string("cannot open ") + path;
+        return false;
+    }
+
+    if (!checkHeader(mappedFile, error))
+    {
+        unmapFile(mappedFile);
+        return false;
+    }
+
+    unmapFile(bookFile);
+    bookFile = mappedFile;
+    bookEntries = (const BookEntry *)(mappedFile.data + sizeof(BookFileHeader));
+    bookEntryCount = ((const BookFileHeader *)mappedFile.data)->entryCount;
+
+    return true;
+}
+
+bool validateBook(const char *path, std::string &error)
+{
+    MappedFile mappedFile;
+    if (!mapFile(path, mappedFile))
+    {
+        error = std::string("cannot open ") + path;
+        return false;
+    }
+
+    bool ok = checkHeader(mappedFile, error);
+    if (ok)
+    {
+        const BookFileHeader *header = (const BookFileHeader *)mappedFile.data;
+        const BookEntry *entries = (const BookEntry *)(mappedFile.data + sizeof(BookFileHeader));
+
+        if (getChecksum(entries, header->entryCount * sizeof(BookEntry)) != header->checksum)
+        {
+            error = "checksum mismatch";
+            ok = false;
+        }
+        for (uint64_t i = 1; ok && i < header->entryCount; i++)
+            if (!isEntryLess(entries[i - 1], entries[i]))
+            {
+                error = "entries not sorted";
+                ok = false;
+            }
+    }
+
+    unmapFile(mappedFile);
+    return ok;
+}
+
+void unloadBook()
+{
+    bookEntries = nullptr;
+    bookEntryCount = 0;
+    unmapFile(bookFile);
+}
+
+bool loadDefaultBook()
+{
+    const char *path = getenv("REVERSI_BOOK");
+    bool required = (path && *path);
+    if (!required)
+        path = BOOK_DEFAULT_NAME;
+
+    std::string error;
+    if (loadBook(path, error))
+        return true;
+
+    // Sin libro por defecto: se busca desde la primera jugada
+    FILE *file = required ? NULL : fopen(path, "rb");
+    if (required || file)
+        LOG_WARN("book: %s: %s, playing without a book", path, error.c_str());
+    if (file)
+        fclose(file);
+
+    return false;
+}
+
+const BookEntry *getBookEntries(uint64_t &count)
+{
+    count = bookEntryCount;
+    return bookEntries;
+}
+
+bool probeBook(const Position &position, std::vector<BookMove> &moves)
+{
+    moves.clear();
+    if (!bookEntries)
+        return false;
+
+    CanonicalBoard key = canonical(position.getPlayer(), position.getOpponent());
+    int symmetry = inverseSymmetry(key.symmetry);
+
+    BookEntry first;
+    memset(&first, 0, sizeof(first));
+    first.player = key.black;
+    first.opponent = key.white;
+
+    const BookEntry *end = bookEntries + bookEntryCount;
+    uint64_t legalMoves = position.getMoves();
+    for (const BookEntry *entry = std::lower_bound(bookEntries, end, first, isEntryLess);
+         entry < end && entry->player == key.black && entry->opponent == key.white; entry++)
+    {
+        BookMove move;
+        move.move = transformSquare(entry->move, symmetry);
+        move.score = entry->score;
+        move.depth = entry->depth;
+
+        if ((legalMoves >> move.move) & 1)
+            moves.push_back(move);
+    }
+
+    std::stable_sort(moves.begin(), moves.end(),
+                     [](const BookMove &a, const BookMove &b) { return a.score > b.score; });
+
+    return !moves.empty();
+}
+
+bool getBookMove(const Position &position, int randomness, BookMove &move)
+{
+    std::vector<BookMove> moves;
+    if (!probeBook(position, moves))
+        return false;
+
+    int candidates = 1;
+    while (candidates < (int)moves.size() &&
+           moves[candidates].score >= moves[0].score - randomness)
+        candidates++;
+
+    std::lock_guard<std::mutex> lock(randomMutex);
+    move = moves[std::uniform_int_distribution<int>(0, candidates - 1)(randomGenerator)];
+
+    return true;
+}
@@ -0,0 +1,135 @@
+/**
+ * @brief Implements the opening book
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "model.h"
+
+#define BOOK_FILE_MAGIC "RVSIBOOK"
+#define BOOK_FILE_VERSION 1
+
+// Loaded at startup if present; REVERSI_BOOK overrides it
+#define BOOK_DEFAULT_NAME "reversi.book"
+
+/**
+ * @brief Book file header (64 bytes, little-endian). Sorted BookEntry
+ * records follow it.
+ */
+struct BookFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t entryCount;
+    uint64_t checksum; // FNV-1a of the entries
+    uint8_t reserved[32];
+};
+
+/**
+ * @brief One analyzed move of a book position (24 bytes). The position is
+ * stored as the side to move's and the opponent's discs, reduced with
+ * canonical() to the smallest of its 8 symmetric forms; entries are sorted by position, then
+ * move, so a lookup is a binary search.
+ */
+struct BookEntry
+{
+    uint64_t player;
+    uint64_t opponent;
+    int16_t score; // SCORE_DISC per disc, for the side to move
+    uint8_t move;  // In the stored orientation
+    uint8_t depth;
+    uint32_t reserved;
+};
+
+/**
+ * @brief A book move for an actual position.
+ */
+struct BookMove
+{
+    int move;
+    int score;
+    int depth;
+};
+
+/**
+ * @brief Writes a book file. Sorts the entries.
+ *
+ * @param path The file path.
+ * @param entries The entries.
+ * @param error Receives an error message on failure.
+ * @return Whether the file was written.
+ */
+bool saveBook(const char *path, std::vector<BookEntry> &entries, std::string &error);
+
+/**
+ * @brief Maps a book file read-only. Must not be called while a search is
+ * running.
+ *
+ * @param path The file path.
+ * @param error Receives an error message on failure.
+ * @return Whether the book was loaded; if not, the previous book is kept.
+ */
+bool loadBook(const char *path, std::string &error);
+
+/**
+ * @brief Checks a book file: header, size, checksum and entry order.
+ *
+ * @param path The file path.
+ * @param error Receives an error message on failure.
+ * @return Whether the book is valid.
+ */
+bool validateBook(const char *path, std::string &error);
+
+/**
+ * @brief Unmaps the loaded book.
+ */
+void unloadBook();
+
+/**
+ * @brief Loads $REVERSI_BOOK, or BOOK_DEFAULT_NAME if it exists. A missing
+ * default book is not an error; invalid files are reported.
+ *
+ * @return Whether a book was loaded.
+ */
+bool loadDefaultBook();
+
+/**
+ * @brief Returns the loaded book's entries.
+ *
+ * @param count Receives the number of entries.
+ * @return The entries, or nullptr if no book is loaded.
+ */
+const BookEntry *getBookEntries(uint64_t &count);
+
+/**
+ * @brief Looks a position up.
+ *
+ * @param position The position.
+ * @param moves Receives the book moves, best first, as squares of the
+ * actual position.
+ * @return Whether the position is in the book.
+ */
+bool probeBook(const Position &position, std::vector<BookMove> &moves);
+
+/**
+ * @brief Picks a book move at random among those scoring within
+ * `randomness` of the best.
+ *
+ * @param position The position.
+ * @param randomness The allowed score loss (SCORE_DISC per disc); 0 always
+ * plays the best move.
+ * @param move Receives the chosen move.
+ * @return Whether the position is in the book.
+ */
+bool getBookMove(const Position &position, int randomness, BookMove &move);
+
+#endif
@@ -0,0 +1,285 @@
+/**
+ * @brief Opening book builder: analyzes openings with the engine
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ai.h"
+#include "bitops.h"
+#include "book.h"
+#include "symmetry.h"
+#include "tt.h"
+#include "weightfile.h"
+
+typedef std::pair<uint64_t, uint64_t> BookKey;
+
+/**
+ * @brief Builder state: analyzed positions by book key, and the lowest ply
+ * each position was expanded from.
+ */
+struct BookBuilder
+{
+    std::map<BookKey, std::vector<BookEntry>> positions;
+    std::map<BookKey, int> expandedPly;
+
+    int plies;
+    int depth;
+    int window;
+    SearchLimits limits;
+
+    int analyzed = 0;
+    std::chrono::steady_clock::time_point start;
+};
+
+static void printUsage()
+{
+    printf("usage: bookbuilder build <book> [plies] [depth] [window]\n"
+           "       bookbuilder extend <book> [plies] [depth] [window]\n"
+           "       bookbuilder info <book>\n"
+           "  plies   expand openings up to this many plies (default 10)\n"
+           "  depth   search depth of each book move (default 10)\n"
+           "  window  expand moves within this many discs of the best (default 2)\n");
+}
+
+/**
+ * @brief Final score of a finished game for `player`; empty squares go to
+ * the winner.
+ */
+static int getFinalScore(GameModel &model, Player player)
+{
+    Player opponent = (player == PLAYER_BLACK) ? PLAYER_WHITE : PLAYER_BLACK;
+    int mine = getScore(model, player);
+    int theirs = getScore(model, opponent);
+    int empties = 64 - mine - theirs;
+    int diff = mine - theirs;
+
+    if (diff > 0)
+        diff += empties;
+    else if (diff < 0)
+        diff -= empties;
+
+    return diff * SCORE_DISC;
+}
+
+/**
+ * @brief Scores every legal move of a position with a search of the reply.
+ */
+static void analyzePosition(BookBuilder &builder, GameModel &model,
+                            int symmetry, std::vector<BookEntry> &entries)
+{
+    Position position = getPosition(model);
+    Player player = model.currentPlayer;
+    CanonicalBoard key = canonical(position.getPlayer(), position.getOpponent());
+
+    // Symmetric moves of a symmetric position lead to the same child
+    std::map<BookKey, int> childScores;
+
+    for (uint64_t moves = position.getMoves(); moves;)
+    {
+        int sq = popLowestSquare(moves);
+
+        GameModel child = model;
+        Square square = {sq / BOARD_SIZE, sq % BOARD_SIZE, (uint64_t)sq};
+        playMove(child, square);
+
+        Position childPosition = getPosition(child);
+        CanonicalBoard childKey = canonical(childPosition.getPlayer(), childPosition.getOpponent());
+        BookKey childBookKey(childKey.black, childKey.white);
+
+        int score;
+        auto childScore = childScores.find(childBookKey);
+        if (childScore != childScores.end())
+            score = childScore->second;
+        else if (child.gameOver)
+            score = getFinalScore(child, player);
+        else
+        {
+            SearchResult result = searchBestMove(child, builder.limits);
+            score = (child.currentPlayer == player) ? result.score : -result.score;
+        }
+        childScores[childBookKey] = score;
+
+        BookEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.player = key.black;
+        entry.opponent = key.white;
+        entry.score = (int16_t)score;
+        entry.move = (uint8_t)transformSquare(sq, symmetry);
+        entry.depth = (uint8_t)builder.depth;
+        entries.push_back(entry);
+    }
+
+    builder.analyzed++;
+    if (!(builder.analyzed % 100))
+    {
+        double elapsed = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - builder.start)
+                             .count();
+        printf("%d positions analyzed, %d in book, %.0f s\n", builder.analyzed,
+               (int)builder.positions.size(), elapsed);
+        fflush(stdout);
+    }
+}
+
+/**
+ * @brief Analyzes a position if needed, then expands its moves within the
+ * window of the best one.
+ */
+static void expand(BookBuilder &builder, GameModel &model, int ply)
+{
+    if (ply >= builder.plies || model.gameOver)
+        return;
+
+    Position position = getPosition(model);
+    CanonicalBoard key = canonical(position.getPlayer(), position.getOpponent());
+    int symmetry = key.symmetry;
+    BookKey bookKey(key.black, key.white);
+
+    auto expanded = builder.expandedPly.find(bookKey);
+    if (expanded != builder.expandedPly.end() && expanded->second <= ply)
+        return;
+    builder.expandedPly[bookKey] = ply;
+
+    std::vector<BookEntry> &entries = builder.positions[bookKey];
+    if (entries.empty())
+        analyzePosition(builder, model, symmetry, entries);
+
+    int bestScore = -SCORE_INF;
+    for (const BookEntry &entry : entries)
+        bestScore = std::max(bestScore, (int)entry.score);
+
+    for (const BookEntry &entry : entries)
+    {
+        if (entry.score < bestScore - builder.window)
+            continue;
+
+        int sq = transformSquare(entry.move, inverseSymmetry(symmetry));
+        GameModel child = model;
+        Square square = {sq / BOARD_SIZE, sq % BOARD_SIZE, (uint64_t)sq};
+        if (playMove(child, square))
+            expand(builder, child, ply + 1);
+    }
+}
+
+static int printInfo(const char *path)
+{
+    std::string error, loadError;
+    bool valid = validateBook(path, error);
+    if (!loadBook(path, loadError))
+    {
+        fprintf(stderr, "bookbuilder: %s: %s\n", path, loadError.c_str());
+        return 1;
+    }
+
+    uint64_t count;
+    const BookEntry *entries = getBookEntries(count);
+    uint64_t positions = 0;
+    for (uint64_t i = 0; i < count; i++)
+        if (!i || entries[i].player != entries[i - 1].player ||
+            entries[i].opponent != entries[i - 1].opponent)
+            positions++;
+
+    printf("%s: %llu positions, %llu moves, %s\n", path,
+           (unsigned long long)positions, (unsigned long long)count,
+           valid ? "OK" : ("INVALID (" + error + ")").c_str());
+
+    // Book moves from the start position
+    GameModel model;
+    initModel(model);
+    model.humanPlayer = PLAYER_WHITE;
+    startModel(model);
+
+    std::vector<BookMove> moves;
+    probeBook(getPosition(model), moves);
+    for (const BookMove &move : moves)
+        printf("  %c%d: %+.2f (depth %d)\n", 'a' + move.move % BOARD_SIZE,
+               move.move / BOARD_SIZE + 1, (double)move.score / SCORE_DISC, move.depth);
+
+    unloadBook();
+    return valid ? 0 : 2;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        printUsage();
+        return 1;
+    }
+
+    const char *command = argv[1];
+    const char *path = argv[2];
+
+    if (!strcmp(command, "info"))
+        return printInfo(path);
+
+    bool extend = !strcmp(command, "extend");
+    if (!extend && strcmp(command, "build"))
+    {
+        printUsage();
+        return 1;
+    }
+
+    BookBuilder builder;
+    builder.plies = (argc > 3) ? atoi(argv[3]) : 10;
+    builder.depth = (argc > 4) ? atoi(argv[4]) : 10;
+    builder.window = (argc > 5) ? (int)(atof(argv[5]) * SCORE_DISC) : 2 * SCORE_DISC;
+    builder.limits.maxDepth = std::max(1, builder.depth - 1);
+    builder.limits.threads = std::max(1, (int)std::thread::hardware_concurrency());
+    builder.limits.useBook = false;
+    builder.start = std::chrono::steady_clock::now();
+
+    loadDefaultWeightFile();
+    ttResize(TT_DEFAULT_SIZE_MB * 8);
+
+    std::string error;
+    if (extend)
+    {
+        if (!loadBook(path, error))
+        {
+            fprintf(stderr, "bookbuilder: %s: %s\n", path, error.c_str());
+            return 1;
+        }
+
+        uint64_t count;
+        const BookEntry *entries = getBookEntries(count);
+        for (uint64_t i = 0; i < count; i++)
+            builder.positions[BookKey(entries[i].player, entries[i].opponent)].push_back(entries[i]);
+        unloadBook();
+
+        printf("%s: %d positions\n", path, (int)builder.positions.size());
+    }
+
+    GameModel model;
+    initModel(model);
+    model.humanPlayer = PLAYER_WHITE;
+    startModel(model);
+    expand(builder, model, 0);
+
+    std::vector<BookEntry> entries;
+    for (auto &position : builder.positions)
+        entries.insert(entries.end(), position.second.begin(), position.second.end());
+
+    if (!saveBook(path, entries, error))
+    {
+        fprintf(stderr, "bookbuilder: %s\n", error.c_str());
+        return 1;
+    }
+
+    printf("%s: %d positions, %d moves (%d analyzed now)\n", path,
+           (int)builder.positions.size(), (int)entries.size(), builder.analyzed);
+
+    return 0;
+}
@@ -6,6 +6,7 @@
  */
 
 #include <algorithm>
+#include <thread>
 
 #include "raylib.h"
 
@@ -13,10 +14,36 @@
 #include "view.h"
 #include "controller.h"
 
+// Time budget for each AI move, in seconds
+#define AI_SEARCH_TIME 1.0
+
+// Book moves within this score of the best one are played at random
+#define AI_BOOK_RANDOMNESS (SCORE_DISC / 2)
+
+// Search statistics overlay, toggled with F3
+static bool showSearchStats = false;
+static SearchStats lastSearchStats;
+
+/**
+ * @brief Returns the search limits used by the AI player.
+ */
+static SearchLimits getAILimits()
+{
+    SearchLimits limits;
+    limits.maxTime = AI_SEARCH_TIME;
+    limits.threads = std::max(1, (int)std::thread::hardware_concurrency());
+    limits.bookRandomness = AI_BOOK_RANDOMNESS;
+
+    return limits;
+}
+
 bool updateView(GameModel &model)
 {
     if (WindowShouldClose())
+    {
+        cancelSearch();
         return false;
+    }
 
     if (model.gameOver)
     {
@@ -24,12 +51,14 @@ bool updateView(GameModel &model)
         {
             if (isMousePointerOverPlayBlackButton())
             {
+                resetPondering();
                 model.humanPlayer = PLAYER_BLACK;
 
                 startModel(model);
             }
             else if (isMousePointerOverPlayWhiteButton())
             {
+                resetPondering();
                 model.humanPlayer = PLAYER_WHITE;
 
                 startModel(model);
@@ -38,6 +67,9 @@ bool updateView(GameModel &model)
     }
     else if (model.currentPlayer == model.humanPlayer)
     {
+        // Think on the human's time
+        startPondering(model, getAILimits());
+
         if (IsMouseButtonPressed(0))
         {
             // Human player
@@ -45,25 +77,30 @@ bool updateView(GameModel &model)
 
             if (isSquareValid(square))
             {
-                Moves validMoves;
+                MoveList validMoves;
                 getValidMoves(model, validMoves, model.black, model.white);
 
                 // Play move if valid
-                for (auto move : validMoves)
+                if (validMoves.contains(square.x * BOARD_SIZE + square.y))
                 {
-                    if ((square.x == move.x) &&
-                        (square.y == move.y))
-                        playMove(model, square);
+                    playMove(model, square);
+                    ponderMove(model, square, getAILimits());
                 }
             }
         }
     }
     else
     {
-        // AI player
-        Square square = getBestMove(model);
+        // AI player: search a snapshot in the background, play when ready
+        SearchResult result;
 
-        playMove(model, square);
+        if (!isSearchPending())
+            startSearchAsync(model, getAILimits());
+        else if (pollSearch(result))
+        {
+            lastSearchStats = result.stats;
+            playMove(model, result.bestMove);
+        }
     }
 
     if ((IsKeyDown(KEY_LEFT_ALT) ||
@@ -71,7 +108,15 @@ bool updateView(GameModel &model)
         IsKeyPressed(KEY_ENTER))
         ToggleFullscreen();
 
-    drawView(model);
+    if (IsKeyPressed(KEY_F3))
+        showSearchStats = !showSearchStats;
+
+    // Live statistics while searching, else those of the last AI move
+    SearchStats stats;
+    if (!showSearchStats || !getSearchProgress(stats))
+        stats = lastSearchStats;
+
+    drawView(model, showSearchStats ? &stats : nullptr);
 
     return true;
 }
@@ -0,0 +1,78 @@
+/**
+ * @brief Implements the CPU feature detection
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#include <cstdint>
+
+#include "cpu.h"
+
+#if defined(REVERSI_X86_64) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#elif defined(REVERSI_X86_64)
+#include <cpuid.h>
+#endif
+
+#ifdef REVERSI_X86_64
+static void cpuid(unsigned leaf, unsigned regs[4])
+{
+#ifdef _MSC_VER
+    __cpuidex((int *)regs, (int)leaf, 0);
+#else
+    __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Estados de registro habilitados por el sistema operativo (XCR0)
+static uint64_t getEnabledStates()
+{
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned eax, edx;
+    __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+#endif
+}
+#endif
+
+static CpuFeatures detectCpuFeatures()
+{
+    CpuFeatures features = {false, false, false, false, false};
+
+#ifdef REVERSI_X86_64
+    unsigned regs[4];
+    cpuid(0, regs);
+    unsigned maxLeaf = regs[0];
+    bool amd = (regs[1] == 0x68747541); // "Auth"enticAMD
+
+    cpuid(1, regs);
+    unsigned family = (regs[0] >> 8) & 0xF;
+    if (family == 0xF)
+        family += (regs[0] >> 20) & 0xFF;
+    features.popcnt = (regs[2] >> 23) & 1;
+    bool osxsave = (regs[2] >> 27) & 1;
+    bool avx = (regs[2] >> 28) & 1;
+    bool ymmEnabled = osxsave && avx && ((getEnabledStates() & 6) == 6);
+
+    if (maxLeaf >= 7)
+    {
+        cpuid(7, regs);
+        features.bmi1 = (regs[1] >> 3) & 1;
+        features.avx2 = ymmEnabled && ((regs[1] >> 5) & 1);
+        features.bmi2 = (regs[1] >> 8) & 1;
+    }
+    features.fastPext = features.bmi2 && !(amd && family < 0x19);
+#endif
+
+    return features;
+}
+
+const CpuFeatures &getCpuFeatures()
+{
+    static const CpuFeatures features = detectCpuFeatures();
+    return features;
+}
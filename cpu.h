@@ -0,0 +1,42 @@
+/**
+ * @brief Implements the CPU feature detection
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#ifndef CPU_H
+#define CPU_H
+
+// x86-64 kernels are compiled per function with target attributes (GCC,
+// Clang) or directly (MSVC), and only called when the CPU supports them
+#if defined(__x86_64__) || defined(_M_X64)
+#define REVERSI_X86_64
+#endif
+
+#if defined(REVERSI_X86_64) && (defined(__GNUC__) || defined(__clang__))
+#define REVERSI_TARGET(x) __attribute__((target(x)))
+#else
+#define REVERSI_TARGET(x)
+#endif
+
+/**
+ * @brief Instruction set extensions usable by the engine.
+ */
+struct CpuFeatures
+{
+    bool popcnt;
+    bool bmi1;
+    bool bmi2;
+    bool avx2;     // Also requires OS support for the YMM registers
+    bool fastPext; // BMI2 PEXT/PDEP in hardware, not microcode (AMD before Zen 3)
+};
+
+/**
+ * @brief Returns the features of the running CPU, detected once.
+ *
+ * @return The CPU features; all false on other architectures.
+ */
+const CpuFeatures &getCpuFeatures();
+
+#endif
@@ -0,0 +1,338 @@
+/**
+ * @brief Training data generator: labeled positions from self-play
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ai.h"
+#include "log.h"
+#include "trainingdata.h"
+#include "tt.h"
+#include "weightfile.h"
+
+struct DataGenerator
+{
+    std::string prefix;
+    int games = 1000;
+    int threads = 1;
+    int depth = 6;
+    int plies = 10;
+    double randomMoves = 0;
+    bool augment = false;
+    uint64_t shardRecords = 16 << 20;
+    size_t hashSize = 16;
+    unsigned int seed = 1;
+
+    std::atomic<int> nextGame{0};
+    std::atomic<int> finishedGames{0};
+    std::atomic<uint64_t> records{0};
+    std::atomic<bool> failed{false};
+};
+
+static void printUsage()
+{
+    printf("usage: datagen <prefix> [options]\n"
+           "  writes <prefix>-tNN-0000.rvd, ... (one stream per thread; appends)\n"
+           "  --games N       self-play games (default 1000)\n"
+           "  --threads N     parallel games (default: all cores)\n"
+           "  --depth D       search depth of each move (default 6)\n"
+           "  --plies N       random opening plies, not recorded (default 10)\n"
+           "  --random P      play a random move instead of the best one with\n"
+           "                  probability P (default 0)\n"
+           "  --augment       write the symmetric forms of each position too\n"
+           "  --shard N       records per shard (default 16M)\n"
+           "  --hash MB       transposition table per thread (default 16)\n"
+           "  --seed N        random seed (default 1)\n"
+           "       datagen info <file>...\n"
+           "  prints the number of records and label statistics of training files\n");
+}
+
+/**
+ * @brief Final disc difference for `player`; empty squares go to the winner.
+ */
+static int getFinalResult(GameModel &model, Player player)
+{
+    Player opponent = (player == PLAYER_BLACK) ? PLAYER_WHITE : PLAYER_BLACK;
+    int mine = getScore(model, player);
+    int theirs = getScore(model, opponent);
+    int empties = 64 - mine - theirs;
+    int diff = mine - theirs;
+
+    if (diff > 0)
+        diff += empties;
+    else if (diff < 0)
+        diff -= empties;
+
+    return diff;
+}
+
+/**
+ * @brief Plays one self-play game, returning its searched positions with
+ * their final result filled in.
+ */
+static void playGame(DataGenerator &generator, int game, TTTable *table,
+                     std::vector<TrainingRecord> &records)
+{
+    // Seeded by game, so the data does not depend on the thread schedule
+    std::mt19937_64 random(generator.seed * 1000003ULL + game);
+    std::uniform_real_distribution<double> uniform(0, 1);
+
+    SearchLimits limits;
+    limits.maxDepth = generator.depth;
+    limits.useBook = false;
+    limits.tt = table;
+
+    GameModel model;
+    initModel(model);
+    model.humanPlayer = PLAYER_BLACK;
+    startModel(model);
+
+    for (int ply = 0; ply < generator.plies && !model.gameOver; ply++)
+    {
+        MoveList validMoves;
+        getValidMoves(model, validMoves, model.black, model.white);
+        playMove(model, validMoves.getSquare(random() % validMoves.size()));
+    }
+
+    records.clear();
+    ttSetThreadTable(table);
+    ttClear();
+    ttSetThreadTable(nullptr);
+
+    while (!model.gameOver)
+    {
+        SearchResult result = searchBestMove(model, limits);
+
+        TrainingRecord record;
+        memset(&record, 0, sizeof(record));
+        record.black = model.black;
+        record.white = model.white;
+        record.score = (int16_t)result.score;
+        record.player = (uint8_t)model.currentPlayer;
+        record.depth = (uint8_t)result.depth;
+        records.push_back(record);
+
+        Square move = result.bestMove;
+        if (generator.randomMoves > 0 && uniform(random) < generator.randomMoves)
+        {
+            MoveList validMoves;
+            getValidMoves(model, validMoves, model.black, model.white);
+            move = validMoves.getSquare(random() % validMoves.size());
+        }
+        playMove(model, move);
+    }
+
+    int blackResult = getFinalResult(model, PLAYER_BLACK);
+    for (TrainingRecord &record : records)
+        record.result = (int8_t)((record.player == PLAYER_BLACK) ? blackResult : -blackResult);
+}
+
+static void runWorker(DataGenerator &generator, int threadIndex)
+{
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), "-t%02d", threadIndex);
+
+    TrainingWriter writer;
+    std::string error;
+    if (!openTrainingWriter(writer, generator.prefix + suffix, generator.shardRecords, error))
+    {
+        fprintf(stderr, "datagen: %s\n", error.c_str());
+        generator.failed.store(true);
+        return;
+    }
+
+    TTTable *table = ttCreate(generator.hashSize);
+    std::vector<TrainingRecord> records;
+    TrainingRecord forms[SYMMETRY_COUNT];
+
+    while (!generator.failed.load())
+    {
+        int game = generator.nextGame++;
+        if (game >= generator.games)
+            break;
+
+        playGame(generator, game, table, records);
+
+        bool ok = true;
+        uint64_t written = 0;
+        for (size_t i = 0; i < records.size() && ok; i++)
+        {
+            int count = 1;
+            forms[0] = records[i];
+            if (generator.augment)
+                count = getTrainingSymmetries(records[i], forms);
+
+            for (int j = 0; j < count && ok; j++)
+                ok = writeTrainingRecord(writer, forms[j], error);
+            written += count;
+        }
+        if (!ok)
+        {
+            fprintf(stderr, "datagen: %s\n", error.c_str());
+            generator.failed.store(true);
+            break;
+        }
+
+        generator.records += written;
+        generator.finishedGames++;
+    }
+
+    if (!closeTrainingWriter(writer, error))
+    {
+        fprintf(stderr, "datagen: %s\n", error.c_str());
+        generator.failed.store(true);
+    }
+    ttDestroy(table);
+}
+
+/**
+ * @brief Streams through training files and prints their statistics.
+ */
+static int printInfo(int count, char *paths[])
+{
+    uint64_t total = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        TrainingFile file;
+        std::string error;
+        if (!openTrainingFile(paths[i], file, error))
+        {
+            fprintf(stderr, "datagen: %s: %s\n", paths[i], error.c_str());
+            return 1;
+        }
+
+        uint64_t wins = 0, draws = 0;
+        double scoreError = 0;
+        for (uint64_t j = 0; j < file.count; j++)
+        {
+            const TrainingRecord &record = file.records[j];
+            wins += (record.result > 0);
+            draws += (record.result == 0);
+
+            double diff = record.score / (double)SCORE_DISC - record.result;
+            scoreError += diff * diff;
+        }
+
+        printf("%s: %llu records, side to move wins %.1f%%, draws %.1f%%, "
+               "score vs result rms %.2f discs\n",
+               paths[i], (unsigned long long)file.count,
+               file.count ? 100.0 * wins / file.count : 0.0,
+               file.count ? 100.0 * draws / file.count : 0.0,
+               file.count ? sqrt(scoreError / file.count) : 0.0);
+
+        total += file.count;
+        closeTrainingFile(file);
+    }
+
+    printf("total: %llu records\n", (unsigned long long)total);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    initLog();
+    loadDefaultWeightFile();
+
+    if (argc < 2 || argv[1][0] == '-')
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (!strcmp(argv[1], "info"))
+        return printInfo(argc - 2, argv + 2);
+
+    DataGenerator generator;
+    generator.prefix = argv[1];
+    generator.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 2; i < argc; i++)
+    {
+        const char *option = argv[i];
+        bool hasValue = (i + 1 < argc);
+
+        if (!strcmp(option, "--games") && hasValue)
+            generator.games = atoi(argv[++i]);
+        else if (!strcmp(option, "--threads") && hasValue)
+            generator.threads = atoi(argv[++i]);
+        else if (!strcmp(option, "--depth") && hasValue)
+            generator.depth = atoi(argv[++i]);
+        else if (!strcmp(option, "--plies") && hasValue)
+            generator.plies = atoi(argv[++i]);
+        else if (!strcmp(option, "--random") && hasValue)
+            generator.randomMoves = atof(argv[++i]);
+        else if (!strcmp(option, "--augment"))
+            generator.augment = true;
+        else if (!strcmp(option, "--shard") && hasValue)
+            generator.shardRecords = strtoull(argv[++i], NULL, 10);
+        else if (!strcmp(option, "--hash") && hasValue)
+            generator.hashSize = (size_t)atoi(argv[++i]);
+        else if (!strcmp(option, "--seed") && hasValue)
+            generator.seed = (unsigned int)atoi(argv[++i]);
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (generator.games < 1 || generator.threads < 1 || generator.depth < 1 ||
+        generator.plies < 0 || generator.hashSize < 1)
+    {
+        printUsage();
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < generator.threads; i++)
+        workers.push_back(std::thread(runWorker, std::ref(generator), i));
+
+    // Progress every few seconds
+    auto lastReport = start;
+    while (generator.finishedGames.load() < generator.games && !generator.failed.load())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastReport >= std::chrono::seconds(5))
+        {
+            double elapsed = std::chrono::duration<double>(now - start).count();
+            printf("games %d/%d  records %llu  records/s %.0f\n",
+                   generator.finishedGames.load(), generator.games,
+                   (unsigned long long)generator.records.load(),
+                   generator.records.load() / elapsed);
+            fflush(stdout);
+            lastReport = now;
+        }
+    }
+
+    for (auto &worker : workers)
+        worker.join();
+
+    double elapsed = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+    printf("games: %d  records: %llu (%.1f MB)  time: %.1f s  records/s: %.0f\n",
+           generator.finishedGames.load(), (unsigned long long)generator.records.load(),
+           generator.records.load() * sizeof(TrainingRecord) / 1048576.0, elapsed,
+           elapsed > 0 ? generator.records.load() / elapsed : 0.0);
+
+    return generator.failed.load() ? 1 : 0;
+}
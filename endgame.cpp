@@ -0,0 +1,744 @@
+/**
+ * @brief Implements the exact endgame solver
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#include "endgame.h"
+#include "bitops.h"
+#include "eval.h"
+#include "tt.h"
+
+// Scores inside the solver are disc differences
+#define ENDGAME_INF 65
+
+// Fastest-first ordering at this many empties or more; parity ordering below
+#define ENDGAME_FASTEST_EMPTIES 6
+
+// Transposition table at this many empties or more
+#define ENDGAME_TT_EMPTIES 8
+
+// Stability cutoff once alpha reaches this many discs
+#define ENDGAME_STABILITY_ALPHA 8
+
+// Root aspiration window half-width, in discs
+#define ENDGAME_ASPIRATION_WINDOW 4
+
+struct EndgameContext
+{
+    uint64_t nodes;
+    uint64_t nextCheck;
+    bool stop;
+    const std::function<bool(uint64_t)> *shouldStop;
+};
+
+static const uint64_t CORNERS = 0x8100000000000081ULL;
+
+// Orden estático: esquinas primero, casillas X al final
+static const int squarePriority[64] = {
+    0, 63, 7, 56, 2, 5, 16, 23, 40, 47, 58, 61, 3, 4, 24, 31,
+    32, 39, 59, 60, 18, 21, 42, 45, 19, 20, 26, 29, 34, 37, 43, 44,
+    27, 28, 35, 36, 11, 12, 25, 30, 33, 38, 51, 52, 10, 13, 17, 22,
+    41, 46, 50, 53, 1, 6, 8, 15, 48, 55, 57, 62, 9, 14, 49, 54,
+};
+
+// Ray from each square in each direction (east, west, south, north and
+// diagonals), not including the square
+static uint64_t rays[64][8];
+
+// Squares around each square: a move needs an opponent disc there
+static uint64_t neighbours[64];
+
+// The 15 + 15 diagonal lines
+static uint64_t diagonals[30];
+static const int rayRowSteps[8] = {0, 0, 1, -1, 1, 1, -1, -1};
+static const int rayColSteps[8] = {1, -1, 0, 0, 1, -1, 1, -1};
+
+static struct EndgameInit
+{
+    EndgameInit()
+    {
+        for (int sq = 0; sq < 64; sq++)
+            for (int dir = 0; dir < 8; dir++)
+            {
+                int row = sq / 8 + rayRowSteps[dir];
+                int col = sq % 8 + rayColSteps[dir];
+                if (row >= 0 && row < 8 && col >= 0 && col < 8)
+                    neighbours[sq] |= 1ULL << (row * 8 + col);
+                for (; row >= 0 && row < 8 && col >= 0 && col < 8;
+                     row += rayRowSteps[dir], col += rayColSteps[dir])
+                    rays[sq][dir] |= 1ULL << (row * 8 + col);
+            }
+
+        // Lines through the first row and the A/H files
+        int count = 0;
+        for (int sq = 0; sq < 8; sq++)
+        {
+            diagonals[count++] = rays[sq][4] | (1ULL << sq);
+            diagonals[count++] = rays[sq][5] | (1ULL << sq);
+        }
+        for (int row = 1; row < 8; row++)
+        {
+            diagonals[count++] = rays[row * 8][4] | (1ULL << (row * 8));
+            diagonals[count++] = rays[row * 8 + 7][5] | (1ULL << (row * 8 + 7));
+        }
+    }
+} endgameInit;
+
+static inline int getQuadrant(int sq)
+{
+    return ((sq >> 2) & 1) | ((sq >> 4) & 2);
+}
+
+/**
+ * @brief Final disc difference; empty squares go to the winner.
+ */
+static inline int finalDiff(uint64_t me, uint64_t opp)
+{
+    int myDiscs = popCount(me);
+    int oppDiscs = popCount(opp);
+    int empties = 64 - myDiscs - oppDiscs;
+    int diff = myDiscs - oppDiscs;
+
+    if (diff > 0)
+        diff += empties;
+    else if (diff < 0)
+        diff -= empties;
+
+    return diff;
+}
+
+/**
+ * @brief Discs that can never be flipped: along each of the four axes, the
+ * line is full or the disc touches the edge or another stable disc.
+ */
+static uint64_t getStableDiscs(uint64_t discs, uint64_t occupied)
+{
+    static const uint64_t FILE_AH = 0x8181818181818181ULL;
+    static const uint64_t ROW_18 = 0xFF000000000000FFULL;
+    static const uint64_t BORDER = 0xFF818181818181FFULL;
+
+    uint64_t fullRows = 0;
+    for (int row = 0; row < 8; row++)
+        if (((occupied >> (row * 8)) & 0xFF) == 0xFF)
+            fullRows |= 0xFFULL << (row * 8);
+
+    uint64_t columns = occupied;
+    columns &= columns >> 32;
+    columns &= columns >> 16;
+    columns &= columns >> 8;
+    uint64_t fullColumns = (columns & 0xFF) * 0x0101010101010101ULL;
+
+    uint64_t fullDiagonals = 0;
+    uint64_t fullAntiDiagonals = 0;
+    for (int i = 0; i < 30; i++)
+        if ((occupied & diagonals[i]) == diagonals[i])
+        {
+            if (i & 1)
+                fullAntiDiagonals |= diagonals[i];
+            else
+                fullDiagonals |= diagonals[i];
+        }
+
+    uint64_t horizontal = fullRows | FILE_AH;
+    uint64_t vertical = fullColumns | ROW_18;
+    uint64_t diagonal = fullDiagonals | BORDER;
+    uint64_t antiDiagonal = fullAntiDiagonals | BORDER;
+
+    uint64_t stable = discs & horizontal & vertical & diagonal & antiDiagonal;
+    for (;;)
+    {
+        uint64_t grown = stable |
+                         (discs &
+                          (horizontal | ((stable << 1) & 0xFEFEFEFEFEFEFEFEULL) |
+                           ((stable >> 1) & 0x7F7F7F7F7F7F7F7FULL)) &
+                          (vertical | (stable << 8) | (stable >> 8)) &
+                          (diagonal | ((stable << 9) & 0xFEFEFEFEFEFEFEFEULL) |
+                           ((stable >> 9) & 0x7F7F7F7F7F7F7F7FULL)) &
+                          (antiDiagonal | ((stable << 7) & 0x7F7F7F7F7F7F7F7FULL) |
+                           ((stable >> 7) & 0xFEFEFEFEFEFEFEFEULL)));
+        if (grown == stable)
+            return stable;
+        stable = grown;
+    }
+}
+
+/**
+ * @brief Upper bound from the opponent's stable discs: cuts when it cannot
+ * beat alpha.
+ */
+static inline bool stabilityCutoff(uint64_t me, uint64_t opp, int alpha, int &score)
+{
+    if (alpha < ENDGAME_STABILITY_ALPHA)
+        return false;
+
+    int bound = 64 - 2 * popCount(getStableDiscs(opp, me | opp));
+    if (bound > alpha)
+        return false;
+
+    score = bound;
+    return true;
+}
+
+/**
+ * @brief Discs flipped by playing the last empty square `sq`: every other
+ * square is occupied, so the discs between `sq` and the nearest own disc
+ * along a ray are all the opponent's.
+ */
+static inline int lastFlipCount(uint64_t me, int sq)
+{
+    static const int raySteps[8] = {1, 1, 8, 8, 9, 7, 7, 9};
+    int count = 0;
+
+    for (int dir = 0; dir < 8; dir++)
+    {
+        uint64_t mine = rays[sq][dir] & me;
+        if (!mine)
+            continue;
+
+        // East, south and the two downward diagonals go toward higher squares
+        bool up = (dir == 0 || dir == 2 || dir == 4 || dir == 5);
+        int nearest = up ? lowestSquare(mine) : highestSquare(mine);
+        int distance = up ? nearest - sq : sq - nearest;
+        count += distance / raySteps[dir] - 1;
+    }
+
+    return count;
+}
+
+/**
+ * @brief One empty square left, `me` to move.
+ */
+static inline int solve1(uint64_t me, int sq)
+{
+    int myDiscs = popCount(me);
+
+    int flips = lastFlipCount(me, sq);
+    if (flips)
+        return 2 * (myDiscs + flips) - 62;
+
+    // Pass: the opponent plays the last square
+    int oppFlips = lastFlipCount(~me & ~(1ULL << sq), sq);
+    if (oppFlips)
+        return 2 * (myDiscs - oppFlips) - 64;
+
+    // Nobody can play: the empty square goes to the winner
+    return (2 * myDiscs > 63) ? 2 * myDiscs - 62 : 2 * myDiscs - 64;
+}
+
+static int solve2(EndgameContext &context, uint64_t me, uint64_t opp,
+                  int alpha, int beta, int sq1, int sq2, bool passed)
+{
+    context.nodes++;
+
+    int bestScore = -ENDGAME_INF;
+    uint64_t flips;
+
+    if ((neighbours[sq1] & opp) && (flips = computeFlips(me, opp, sq1)))
+    {
+        bestScore = -solve1(opp ^ flips, sq2);
+        if (bestScore >= beta)
+            return bestScore;
+    }
+    if ((neighbours[sq2] & opp) && (flips = computeFlips(me, opp, sq2)))
+    {
+        int score = -solve1(opp ^ flips, sq1);
+        if (score > bestScore)
+            bestScore = score;
+    }
+
+    if (bestScore == -ENDGAME_INF)
+        bestScore = passed ? finalDiff(me, opp)
+                           : -solve2(context, opp, me, -beta, -alpha, sq1, sq2, true);
+
+    return bestScore;
+}
+
+/**
+ * @brief Moves squares in odd quadrants (an odd number of empties) first:
+ * the side that moves there tends to get the last move of the quadrant.
+ */
+static inline void sortByParity(int *squares, int count)
+{
+    int parity = 0;
+    for (int i = 0; i < count; i++)
+        parity ^= 1 << getQuadrant(squares[i]);
+
+    int odd = 0;
+    for (int i = 0; i < count; i++)
+        if (parity & (1 << getQuadrant(squares[i])))
+        {
+            int sq = squares[i];
+            for (int j = i; j > odd; j--)
+                squares[j] = squares[j - 1];
+            squares[odd++] = sq;
+        }
+}
+
+static int solve3(EndgameContext &context, uint64_t me, uint64_t opp,
+                  int alpha, int beta, int sq1, int sq2, int sq3, bool passed)
+{
+    context.nodes++;
+
+    int bestScore = -ENDGAME_INF;
+    uint64_t flips;
+
+    if ((neighbours[sq1] & opp) && (flips = computeFlips(me, opp, sq1)))
+    {
+        bestScore = -solve2(context, opp ^ flips, me | flips | (1ULL << sq1),
+                            -beta, -alpha, sq2, sq3, false);
+        if (bestScore >= beta)
+            return bestScore;
+        if (bestScore > alpha)
+            alpha = bestScore;
+    }
+    if ((neighbours[sq2] & opp) && (flips = computeFlips(me, opp, sq2)))
+    {
+        int score = -solve2(context, opp ^ flips, me | flips | (1ULL << sq2),
+                            -beta, -alpha, sq1, sq3, false);
+        if (score > bestScore)
+        {
+            bestScore = score;
+            if (bestScore >= beta)
+                return bestScore;
+            if (bestScore > alpha)
+                alpha = bestScore;
+        }
+    }
+    if ((neighbours[sq3] & opp) && (flips = computeFlips(me, opp, sq3)))
+    {
+        int score = -solve2(context, opp ^ flips, me | flips | (1ULL << sq3),
+                            -beta, -alpha, sq1, sq2, false);
+        if (score > bestScore)
+            bestScore = score;
+    }
+
+    if (bestScore == -ENDGAME_INF)
+        bestScore = passed ? finalDiff(me, opp)
+                           : -solve3(context, opp, me, -beta, -alpha, sq1, sq2, sq3, true);
+
+    return bestScore;
+}
+
+static int solve4(EndgameContext &context, uint64_t me, uint64_t opp,
+                  int alpha, int beta, const int *squares, bool passed)
+{
+    context.nodes++;
+
+    // Remaining squares after each move, keeping parity order
+    static const int others[4][3] = {{1, 2, 3}, {0, 2, 3}, {0, 1, 3}, {0, 1, 2}};
+
+    int bestScore = -ENDGAME_INF;
+
+    for (int i = 0; i < 4; i++)
+    {
+        int sq = squares[i];
+        uint64_t flips = (neighbours[sq] & opp) ? computeFlips(me, opp, sq) : 0;
+        if (!flips)
+            continue;
+
+        int score = -solve3(context, opp ^ flips, me | flips | (1ULL << sq),
+                            -beta, -alpha, squares[others[i][0]],
+                            squares[others[i][1]], squares[others[i][2]], false);
+        if (score > bestScore)
+        {
+            bestScore = score;
+            if (bestScore >= beta)
+                return bestScore;
+            if (bestScore > alpha)
+                alpha = bestScore;
+        }
+    }
+
+    if (bestScore == -ENDGAME_INF)
+        bestScore = passed ? finalDiff(me, opp)
+                           : -solve4(context, opp, me, -beta, -alpha, squares, true);
+
+    return bestScore;
+}
+
+/**
+ * @brief Up to 4 empties: dispatches to the dedicated solvers.
+ */
+static int solveShallow(EndgameContext &context, uint64_t me, uint64_t opp,
+                        int alpha, int beta)
+{
+    int squares[4];
+    int count = 0;
+    for (uint64_t e = ~(me | opp); e; e &= e - 1)
+        squares[count++] = lowestSquare(e);
+    sortByParity(squares, count);
+
+    switch (count)
+    {
+    case 0:
+        context.nodes++;
+        return finalDiff(me, opp);
+    case 1:
+        context.nodes++;
+        return solve1(me, squares[0]);
+    case 2:
+        return solve2(context, me, opp, alpha, beta, squares[0], squares[1], false);
+    case 3:
+        return solve3(context, me, opp, alpha, beta, squares[0], squares[1], squares[2], false);
+    default:
+        return solve4(context, me, opp, alpha, beta, squares, false);
+    }
+}
+
+/**
+ * @brief 5 to ENDGAME_FASTEST_EMPTIES - 1 empties: parity ordering, then
+ * static square priority.
+ */
+static int solveParity(EndgameContext &context, uint64_t me, uint64_t opp,
+                       int alpha, int beta, int empties)
+{
+    if (empties <= 4)
+        return solveShallow(context, me, opp, alpha, beta);
+
+    context.nodes++;
+
+    int bound;
+    if (stabilityCutoff(me, opp, alpha, bound))
+        return bound;
+
+    uint64_t empty = ~(me | opp);
+    uint64_t moves = generateMoves(me, opp);
+    if (!moves)
+    {
+        if (!generateMoves(opp, me))
+            return finalDiff(me, opp);
+        return -solveParity(context, opp, me, -beta, -alpha, empties);
+    }
+
+    int parity = 0;
+    for (uint64_t e = empty; e; e &= e - 1)
+        parity ^= 1 << getQuadrant(lowestSquare(e));
+
+    int bestScore = -ENDGAME_INF;
+
+    // Odd quadrants first, then even ones
+    for (int pass = 0; pass < 2; pass++)
+        for (int i = 0; i < 64; i++)
+        {
+            int sq = squarePriority[i];
+            if (!((moves >> sq) & 1) ||
+                (((parity >> getQuadrant(sq)) & 1) != (pass == 0)))
+                continue;
+
+            uint64_t flips = computeFlips(me, opp, sq);
+            int score = -solveParity(context, opp ^ flips, me | flips | (1ULL << sq),
+                                     -beta, -alpha, empties - 1);
+            if (score > bestScore)
+            {
+                bestScore = score;
+                if (bestScore >= beta)
+                    return bestScore;
+                if (bestScore > alpha)
+                    alpha = bestScore;
+            }
+        }
+
+    return bestScore;
+}
+
+/**
+ * @brief Orders moves fastest-first: fewest opponent replies (corners count
+ * double), odd quadrants breaking ties; the table move goes first.
+ */
+static int orderFastestFirst(Position &position, uint64_t moves, int *squares,
+                             int ttMove)
+{
+    int scores[MAX_MOVES];
+    int count = 0;
+
+    int parity = 0;
+    for (uint64_t e = ~(position.black | position.white); e; e &= e - 1)
+        parity ^= 1 << getQuadrant(lowestSquare(e));
+
+    for (; moves; moves &= moves - 1)
+    {
+        int sq = lowestSquare(moves);
+        int score;
+
+        if (sq == ttMove)
+            score = ENDGAME_INF * 64;
+        else
+        {
+            uint64_t flips = position.makeMove(sq);
+            uint64_t replies = position.getMoves();
+            position.undoMove(sq, flips);
+
+            score = -16 * (popCount(replies) + popCount(replies & CORNERS));
+            if ((parity >> getQuadrant(sq)) & 1)
+                score += 4;
+        }
+
+        int i = count++;
+        for (; i > 0 && scores[i - 1] < score; i--)
+        {
+            scores[i] = scores[i - 1];
+            squares[i] = squares[i - 1];
+        }
+        scores[i] = score;
+        squares[i] = sq;
+    }
+
+    return count;
+}
+
+static bool checkStop(EndgameContext &context)
+{
+    if (!context.stop && context.nodes >= context.nextCheck)
+    {
+        context.nextCheck = context.nodes + 1024;
+        if ((*context.shouldStop)(context.nodes))
+            context.stop = true;
+    }
+
+    return context.stop;
+}
+
+static int solveFastest(EndgameContext &context, Position &position,
+                        int alpha, int beta, int empties)
+{
+    if (empties < ENDGAME_FASTEST_EMPTIES)
+        return solveParity(context, position.getPlayer(), position.getOpponent(),
+                           alpha, beta, empties);
+
+    context.nodes++;
+    if (checkStop(context))
+        return 0;
+
+    int bound;
+    if (stabilityCutoff(position.getPlayer(), position.getOpponent(), alpha, bound))
+        return bound;
+
+    uint64_t moves = position.getMoves();
+    if (!moves)
+    {
+        if (!generateMoves(position.getOpponent(), position.getPlayer()))
+            return finalDiff(position.getPlayer(), position.getOpponent());
+
+        position.passMove();
+        int score = -solveFastest(context, position, -beta, -alpha, empties);
+        position.passMove();
+        return score;
+    }
+
+    // Table scores are SCORE_DISC per disc; entries at least `empties` deep
+    // are exact solves, also when stored by the midgame search
+    int ttMove = TT_NO_MOVE;
+    bool useTT = (empties >= ENDGAME_TT_EMPTIES);
+    if (useTT)
+    {
+        TTData ttData;
+        if (ttProbe(position.hash, ttData))
+        {
+            ttMove = ttData.move;
+
+            int ttScore = ttData.score / SCORE_DISC;
+            if (ttData.depth >= empties &&
+                ((ttData.bound == TT_BOUND_EXACT) ||
+                 (ttData.bound == TT_BOUND_LOWER && ttScore >= beta) ||
+                 (ttData.bound == TT_BOUND_UPPER && ttScore <= alpha)))
+                return ttScore;
+        }
+    }
+
+    int squares[MAX_MOVES];
+    int count = orderFastestFirst(position, moves, squares, ttMove);
+    int bestScore = -ENDGAME_INF;
+    int bestMove = TT_NO_MOVE;
+    int originalAlpha = alpha;
+
+    for (int i = 0; i < count; i++)
+    {
+        int sq = squares[i];
+        uint64_t flips = position.makeMove(sq);
+        int score;
+
+        if (i == 0)
+            score = -solveFastest(context, position, -beta, -alpha, empties - 1);
+        else
+        {
+            score = -solveFastest(context, position, -alpha - 1, -alpha, empties - 1);
+            if (score > alpha && score < beta)
+                score = -solveFastest(context, position, -beta, -alpha, empties - 1);
+        }
+
+        position.undoMove(sq, flips);
+
+        if (context.stop)
+            return 0;
+
+        if (score > bestScore)
+        {
+            bestScore = score;
+            bestMove = sq;
+            if (bestScore >= beta)
+                break;
+            if (bestScore > alpha)
+                alpha = bestScore;
+        }
+    }
+
+    if (useTT)
+    {
+        TTBound bound = (bestScore <= originalAlpha) ? TT_BOUND_UPPER
+                        : (bestScore >= beta)        ? TT_BOUND_LOWER
+                                                     : TT_BOUND_EXACT;
+        ttStore(position.hash, empties, bestScore * SCORE_DISC, bound, bestMove);
+    }
+
+    return bestScore;
+}
+
+/**
+ * @brief Solves the root moves; squares[0] receives the best move when it
+ * is proven better than alpha.
+ */
+static int solveRoot(EndgameContext &context, Position &position, int *squares,
+                     int count, int empties, int alpha, int beta)
+{
+    int bestScore = -ENDGAME_INF;
+
+    context.nodes++;
+
+    for (int i = 0; i < count; i++)
+    {
+        int sq = squares[i];
+        uint64_t flips = position.makeMove(sq);
+        int score;
+
+        if (i == 0)
+            score = -solveFastest(context, position, -beta, -alpha, empties - 1);
+        else
+        {
+            score = -solveFastest(context, position, -alpha - 1, -alpha, empties - 1);
+            if (score > alpha && score < beta)
+                score = -solveFastest(context, position, -beta, -alpha, empties - 1);
+        }
+
+        position.undoMove(sq, flips);
+
+        if (context.stop)
+            break;
+
+        if (score > bestScore)
+        {
+            bestScore = score;
+
+            if (score > alpha)
+            {
+                for (int j = i; j > 0; j--)
+                    squares[j] = squares[j - 1];
+                squares[0] = sq;
+
+                alpha = score;
+                if (alpha >= beta)
+                    break;
+            }
+        }
+    }
+
+    return bestScore;
+}
+
+bool solveEndgame(const Position &rootPosition, EndgameMode mode,
+                  const std::function<bool(uint64_t)> &shouldStop, EndgameResult &result)
+{
+    EndgameContext context;
+    context.nodes = 0;
+    context.nextCheck = 1024;
+    context.stop = false;
+    context.shouldStop = &shouldStop;
+
+    Position position = rootPosition;
+    int empties = 64 - popCount(position.black | position.white);
+
+    result = EndgameResult();
+
+    uint64_t moves = position.getMoves();
+    if (!moves)
+    {
+        result.complete = true;
+        return true;
+    }
+
+    int ttMove = TT_NO_MOVE;
+    TTData ttData;
+    if (ttProbe(position.hash, ttData))
+        ttMove = ttData.move;
+
+    int squares[MAX_MOVES];
+    int count = orderFastestFirst(position, moves, squares, ttMove);
+
+    // WLD: a null window around a draw. Exact: an aspiration window around
+    // the static evaluation, as narrow windows prune far more
+    int alpha = -1;
+    int beta = 1;
+    if (mode == ENDGAME_EXACT)
+    {
+        int guess = evaluate(position) / SCORE_DISC;
+        alpha = guess - ENDGAME_ASPIRATION_WINDOW;
+        beta = guess + ENDGAME_ASPIRATION_WINDOW;
+        if (alpha < -ENDGAME_INF)
+            alpha = -ENDGAME_INF;
+        if (beta > ENDGAME_INF)
+            beta = ENDGAME_INF;
+    }
+
+    int bestScore;
+    int window = ENDGAME_ASPIRATION_WINDOW;
+    for (;;)
+    {
+        bestScore = solveRoot(context, position, squares, count, empties, alpha, beta);
+        if (context.stop || mode == ENDGAME_WLD)
+            break;
+
+        // Fail-soft bounds: re-search next to the bound, widening each time
+        window *= 2;
+        if (bestScore <= alpha && alpha > -ENDGAME_INF)
+        {
+            beta = bestScore + 1;
+            alpha = (bestScore - window < -ENDGAME_INF) ? -ENDGAME_INF : bestScore - window;
+        }
+        else if (bestScore >= beta && beta < ENDGAME_INF)
+        {
+            alpha = bestScore - 1;
+            beta = (bestScore + window > ENDGAME_INF) ? ENDGAME_INF : bestScore + window;
+        }
+        else
+            break;
+    }
+
+    result.bestMove = squares[0];
+    result.nodes = context.nodes;
+    result.complete = !context.stop;
+    if (!result.complete)
+        return false;
+
+    if (mode == ENDGAME_WLD)
+        result.score = (bestScore > 0) ? SCORE_DISC : (bestScore < 0) ? -SCORE_DISC : 0;
+    else
+        result.score = bestScore * SCORE_DISC;
+
+    TTBound bound = (bestScore <= alpha) ? TT_BOUND_UPPER
+                    : (bestScore >= beta) ? TT_BOUND_LOWER
+                                          : TT_BOUND_EXACT;
+    ttStore(position.hash, empties, bestScore * SCORE_DISC, bound, result.bestMove);
+
+    // Principal variation from the table
+    result.pv.push_back(result.bestMove);
+    position.makeMove(result.bestMove);
+    while ((int)result.pv.size() < empties && ttProbe(position.hash, ttData) &&
+           ttData.move != TT_NO_MOVE && ((position.getMoves() >> ttData.move) & 1))
+    {
+        result.pv.push_back(ttData.move);
+        position.makeMove(ttData.move);
+    }
+
+    return true;
+}
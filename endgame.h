@@ -0,0 +1,57 @@
+/**
+ * @brief Implements the exact endgame solver
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "model.h"
+
+// Solve instead of searching at this many empty squares or fewer
+#define ENDGAME_DEFAULT_EMPTIES 20
+
+enum EndgameMode
+{
+    ENDGAME_EXACT, // Exact final disc difference
+    ENDGAME_WLD,   // Win, loss or draw only (faster)
+};
+
+/**
+ * @brief The outcome of an endgame solve.
+ */
+struct EndgameResult
+{
+    int bestMove = -1; // 0-63, -1 if there is no legal move
+
+    // Final disc difference * SCORE_DISC for the side to move; in WLD mode
+    // -SCORE_DISC, 0 or SCORE_DISC
+    int score = 0;
+
+    uint64_t nodes = 0;
+    bool complete = false; // false if stopped before the solve finished
+    std::vector<int> pv;
+};
+
+/**
+ * @brief Solves a position to the end of the game: fastest-first ordering
+ * with the transposition table at high empty counts, quadrant parity
+ * ordering below that, and dedicated solvers for the last 1 to 4 empties.
+ *
+ * @param position The position.
+ * @param mode Exact score or win/loss/draw.
+ * @param shouldStop Polled every 1024 nodes with the node count; returning
+ * true stops the solve. bestMove is then the best root move solved so far.
+ * @param result Receives the result.
+ * @return Whether the solve completed.
+ */
+bool solveEndgame(const Position &position, EndgameMode mode,
+                  const std::function<bool(uint64_t)> &shouldStop, EndgameResult &result);
+
+#endif
@@ -0,0 +1,596 @@
+/**
+ * @brief Engine server: plays over the NBoard protocol on stdin/stdout
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ai.h"
+#include "book.h"
+#include "log.h"
+#include "tt.h"
+#include "weightfile.h"
+
+#define ENGINE_NAME "Reversi"
+
+// Search depth until the GUI sends "set depth"
+#define ENGINE_DEFAULT_DEPTH 12
+
+// Time kept in reserve on the game clock, and the least time for a move,
+// in seconds
+#define ENGINE_TIME_RESERVE 1.0
+#define ENGINE_MIN_MOVE_TIME 0.05
+
+/**
+ * @brief The game being played. It persists between commands, as do the
+ * transposition table and the search contexts.
+ */
+struct Engine
+{
+    GameModel start;        // Position the game started from
+    std::vector<int> moves; // Moves played since, -1 for a pass
+    GameModel model;        // Current position
+
+    int depth = ENGINE_DEFAULT_DEPTH;
+    int threads = 1;
+    double moveTime = 0;         // "set movetime"; overrides the clock
+    double gameTime = 0;         // GGF TI[] of each player; 0: untimed
+    double usedTime[2] = {0, 0}; // Charged with the times of the moves
+};
+
+/**
+ * @brief A scored move for "hint".
+ */
+struct Hint
+{
+    int score;
+    int depth;
+    std::vector<Square> pv;
+};
+
+static void printUsage()
+{
+    printf("usage: engine [--threads N] [--hash MB]\n"
+           "  speaks the NBoard protocol on stdin/stdout:\n"
+           "  nboard, set depth|game|contempt|movetime, move, go, hint, analyze,\n"
+           "  ping, learn, quit\n");
+}
+
+static std::string getSquareName(Square square)
+{
+    char name[3] = {(char)('a' + square.y), (char)('1' + square.x), 0};
+    return name;
+}
+
+static Square getSquare(int sq)
+{
+    Square square = {sq / BOARD_SIZE, sq % BOARD_SIZE, (uint64_t)sq};
+    return square;
+}
+
+/**
+ * @brief Parses "d3" or "D3"; -1 if it is not a square.
+ */
+static int parseSquare(const std::string &text)
+{
+    if (text.size() < 2)
+        return -1;
+
+    int col = tolower(text[0]) - 'a';
+    int row = text[1] - '1';
+    if (col < 0 || col >= BOARD_SIZE || row < 0 || row >= BOARD_SIZE)
+        return -1;
+
+    return row * BOARD_SIZE + col;
+}
+
+/**
+ * @brief Parses a GGF time, "[[h:]m:]s"; extra fields after a '/' (the
+ * increment) are ignored.
+ */
+static double parseTime(const std::string &text)
+{
+    std::stringstream stream(text.substr(0, text.find('/')));
+    std::string field;
+    double time = 0;
+
+    while (std::getline(stream, field, ':'))
+        time = time * 60 + atof(field.c_str());
+
+    return time;
+}
+
+static std::string formatScore(int score)
+{
+    char text[16];
+    snprintf(text, sizeof(text), "%.2f", score / (double)SCORE_DISC);
+    return text;
+}
+
+/**
+ * @brief Final score for the side to move; empty squares go to the winner.
+ */
+static int getFinalScore(GameModel &model)
+{
+    Player opponent = (model.currentPlayer == PLAYER_BLACK) ? PLAYER_WHITE : PLAYER_BLACK;
+    int mine = getScore(model, model.currentPlayer);
+    int theirs = getScore(model, opponent);
+    int empties = BOARD_SIZE * BOARD_SIZE - mine - theirs;
+    int diff = mine - theirs;
+
+    if (diff > 0)
+        diff += empties;
+    else if (diff < 0)
+        diff -= empties;
+
+    return diff * SCORE_DISC;
+}
+
+/**
+ * @brief Sets up a position, passing for the side to move if it has no
+ * moves.
+ */
+static void setPosition(GameModel &model, uint64_t black, uint64_t white, Player player)
+{
+    initModel(model);
+    model.black = black;
+    model.white = white;
+    model.currentPlayer = player;
+    model.hash = computeHash(black, white, player);
+    model.gameOver = false;
+
+    Position position = getPosition(model);
+    if (!position.getMoves())
+    {
+        position.passMove();
+        model.currentPlayer = position.currentPlayer;
+        model.hash = position.hash;
+
+        if (!position.getMoves())
+            model.gameOver = true;
+    }
+}
+
+/**
+ * @brief Returns the position after the first `count` moves of the game.
+ */
+static GameModel getGamePosition(const Engine &engine, size_t count)
+{
+    GameModel model = engine.start;
+
+    for (size_t i = 0; i < count; i++)
+        if (engine.moves[i] >= 0)
+            playMove(model, getSquare(engine.moves[i]));
+
+    return model;
+}
+
+/**
+ * @brief Plays a move given as "d3[/eval[/time]]" or "PA", charging its
+ * time to `player`. The model passes by itself, so passes only keep the
+ * move numbers in step; one is legal only if the model already passed
+ * for `player`, who had no moves.
+ */
+static bool playGameMove(Engine &engine, const std::string &text, Player player,
+                         std::string &error)
+{
+    std::string move = text.substr(0, text.find('/'));
+    size_t timeStart = text.find('/', move.size() + 1);
+    double time = (timeStart != std::string::npos) ? atof(text.c_str() + timeStart + 1) : 0;
+
+    std::string lower = move;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower == "pa" || lower == "pass")
+    {
+        GameModel &model = engine.model;
+        uint64_t mine = (player == PLAYER_BLACK) ? model.black : model.white;
+        uint64_t theirs = (player == PLAYER_BLACK) ? model.white : model.black;
+        bool skipped = (player != model.currentPlayer || model.gameOver);
+        bool repeated = (!engine.moves.empty() && engine.moves.back() < 0);
+
+        if (!skipped || repeated || generateMoves(mine, theirs))
+        {
+            error = "illegal move " + move;
+            return false;
+        }
+
+        engine.moves.push_back(-1);
+        engine.usedTime[player] += time;
+        return true;
+    }
+
+    int sq = parseSquare(move);
+    if (sq < 0 || engine.model.gameOver || player != engine.model.currentPlayer ||
+        !playMove(engine.model, getSquare(sq)))
+    {
+        error = "illegal move " + move;
+        return false;
+    }
+
+    engine.moves.push_back(sq);
+    engine.usedTime[player] += time;
+    return true;
+}
+
+/**
+ * @brief Sets the game from a GGF record, e.g.
+ * "(;GM[Othello]TI[5:00]BO[8 -...- *]B[d3//1.2]W[c5];)".
+ */
+static bool setGame(Engine &engine, const std::string &ggf, std::string &error)
+{
+    Engine game = engine;
+    game.moves.clear();
+    game.gameTime = 0;
+    game.usedTime[0] = game.usedTime[1] = 0;
+
+    bool hasBoard = false;
+    std::vector<std::pair<Player, std::string>> moves;
+
+    for (size_t i = ggf.find('['); i != std::string::npos; i = ggf.find('[', i))
+    {
+        size_t end = ggf.find(']', i);
+        if (end == std::string::npos)
+        {
+            error = "unterminated GGF tag";
+            return false;
+        }
+
+        size_t tagStart = i;
+        while (tagStart > 0 && isupper((unsigned char)ggf[tagStart - 1]))
+            tagStart--;
+        std::string tag = ggf.substr(tagStart, i - tagStart);
+        std::string value = ggf.substr(i + 1, end - i - 1);
+        i = end + 1;
+
+        if (tag == "BO")
+        {
+            // "8 <64 squares, row 1 first> <side to move>"; '*' is black
+            uint64_t black = 0, white = 0;
+            int squares = 0;
+            size_t j = value.find(' ');
+
+            for (; j < value.size() && squares < BOARD_SIZE * BOARD_SIZE; j++)
+            {
+                char c = value[j];
+                if (c == '*')
+                    black |= 1ULL << squares++;
+                else if (c == 'O' || c == 'o')
+                    white |= 1ULL << squares++;
+                else if (c == '-' || c == '.')
+                    squares++;
+            }
+            while (j < value.size() && isspace((unsigned char)value[j]))
+                j++;
+
+            if (atoi(value.c_str()) != BOARD_SIZE || squares != BOARD_SIZE * BOARD_SIZE ||
+                j >= value.size())
+            {
+                error = "bad GGF board";
+                return false;
+            }
+
+            Player player = (value[j] == '*') ? PLAYER_BLACK : PLAYER_WHITE;
+            setPosition(game.start, black, white, player);
+            hasBoard = true;
+        }
+        else if (tag == "TI")
+            game.gameTime = parseTime(value);
+        else if (tag == "B" || tag == "W")
+            moves.push_back(std::make_pair(tag == "B" ? PLAYER_BLACK : PLAYER_WHITE, value));
+    }
+
+    if (!hasBoard)
+    {
+        error = "GGF without a board";
+        return false;
+    }
+
+    game.model = game.start;
+    for (auto &move : moves)
+        if (!playGameMove(game, move.second, move.first, error))
+            return false;
+
+    engine = game;
+    return true;
+}
+
+/**
+ * @brief Time for the next move: "set movetime", or the remaining game
+ * time spread over the side to move's remaining moves; 0 when untimed.
+ */
+static double getMoveTime(Engine &engine)
+{
+    if (engine.moveTime > 0)
+        return engine.moveTime;
+    if (engine.gameTime <= 0)
+        return 0;
+
+    int empties = BOARD_SIZE * BOARD_SIZE - getScore(engine.model, PLAYER_BLACK) -
+                  getScore(engine.model, PLAYER_WHITE);
+    int movesLeft = std::max(1, (empties + 1) / 2);
+    double remaining = engine.gameTime - engine.usedTime[engine.model.currentPlayer] -
+                       ENGINE_TIME_RESERVE;
+
+    return std::max(ENGINE_MIN_MOVE_TIME, remaining / movesLeft);
+}
+
+static SearchLimits getLimits(const Engine &engine, int depth, double time)
+{
+    SearchLimits limits;
+    limits.maxDepth = std::max(1, depth);
+    limits.maxTime = time;
+    limits.threads = engine.threads;
+
+    return limits;
+}
+
+/**
+ * @brief "go": searches the current position and answers "=== move/eval/time".
+ * The position is not changed; the GUI sends the move back with "move".
+ */
+static void go(Engine &engine)
+{
+    if (engine.model.gameOver)
+    {
+        printf("=== PA\n");
+        return;
+    }
+
+    SearchLimits limits = getLimits(engine, engine.depth, getMoveTime(engine));
+    limits.progress = [](const SearchStats &stats) {
+        printf("nodestats %llu %.3f\n", (unsigned long long)stats.nodes, stats.time);
+        printf("status depth %d\n", stats.depth);
+        fflush(stdout);
+    };
+
+    SearchResult result = searchBestMove(engine.model, limits);
+
+    printf("nodestats %llu %.3f\n", (unsigned long long)result.nodes, result.time);
+    printf("status\n");
+    printf("=== %s/%s/%.2f\n", getSquareName(result.bestMove).c_str(),
+           formatScore(result.score).c_str(), result.time);
+}
+
+/**
+ * @brief "hint n": the n best moves of the current position, as "book"
+ * lines if it is in the book, else as "search" lines.
+ */
+static void hint(Engine &engine, int count)
+{
+    printf("status Analyzing\n");
+    fflush(stdout);
+
+    Position position = getPosition(engine.model);
+    std::vector<BookMove> bookMoves;
+
+    if (engine.model.gameOver)
+        ;
+    else if (probeBook(position, bookMoves))
+    {
+        for (int i = 0; i < count && i < (int)bookMoves.size(); i++)
+            printf("book %s %s 0 %d\n", getSquareName(getSquare(bookMoves[i].move)).c_str(),
+                   formatScore(bookMoves[i].score).c_str(), bookMoves[i].depth);
+    }
+    else
+    {
+        MoveList validMoves;
+        getValidMoves(engine.model, validMoves, engine.model.black, engine.model.white);
+
+        // Each move gets an equal share of the time
+        double time = getMoveTime(engine) / validMoves.size();
+        std::vector<Hint> hints;
+
+        for (int i = 0; i < validMoves.size(); i++)
+        {
+            Hint moveHint;
+            GameModel child = engine.model;
+            playMove(child, validMoves.getSquare(i));
+            moveHint.pv.push_back(validMoves.getSquare(i));
+
+            if (child.gameOver)
+            {
+                moveHint.score = getFinalScore(child);
+                moveHint.depth = 1;
+            }
+            else
+            {
+                SearchLimits limits = getLimits(engine, engine.depth - 1, time);
+                limits.useBook = false;
+                SearchResult result = searchBestMove(child, limits);
+
+                moveHint.score = result.score;
+                moveHint.depth = result.depth + 1;
+                moveHint.pv.insert(moveHint.pv.end(), result.pv.begin(), result.pv.end());
+            }
+
+            // Scores for the side to move before the move
+            if (child.currentPlayer != engine.model.currentPlayer)
+                moveHint.score = -moveHint.score;
+            hints.push_back(moveHint);
+        }
+
+        std::stable_sort(hints.begin(), hints.end(), [](const Hint &a, const Hint &b) {
+            return a.score > b.score;
+        });
+
+        for (int i = 0; i < count && i < (int)hints.size(); i++)
+        {
+            std::string pv;
+            for (const Square &square : hints[i].pv)
+                pv += getSquareName(square);
+
+            printf("search %s %s 0 %d\n", pv.c_str(), formatScore(hints[i].score).c_str(),
+                   hints[i].depth);
+        }
+    }
+
+    printf("status\n");
+}
+
+/**
+ * @brief "analyze": scores each position of the game for its side to move,
+ * from the last one back to the start, as "analysis <moves> <eval>".
+ */
+static void analyze(Engine &engine)
+{
+    printf("status Analyzing\n");
+    fflush(stdout);
+
+    for (size_t count = engine.moves.size() + 1; count-- > 0;)
+    {
+        GameModel model = getGamePosition(engine, count);
+        int score;
+
+        if (model.gameOver)
+            score = getFinalScore(model);
+        else
+        {
+            SearchLimits limits = getLimits(engine, engine.depth, 0);
+            limits.useBook = false;
+            score = searchBestMove(model, limits).score;
+        }
+
+        printf("analysis %d %s\n", (int)count, formatScore(score).c_str());
+        fflush(stdout);
+    }
+
+    printf("status\n");
+}
+
+/**
+ * @brief Runs one command line; false on "quit".
+ */
+static bool runCommand(Engine &engine, const std::string &line)
+{
+    std::stringstream stream(line);
+    std::string command;
+    std::string error;
+    stream >> command;
+
+    if (command.empty())
+        ;
+    else if (command == "quit")
+        return false;
+    else if (command == "nboard")
+        printf("set myname %s\n", ENGINE_NAME);
+    else if (command == "ping")
+    {
+        // Commands run in order, so everything before has finished
+        std::string n;
+        stream >> n;
+        printf("pong %s\n", n.c_str());
+    }
+    else if (command == "learn")
+        printf("learned\n");
+    else if (command == "set")
+    {
+        std::string name;
+        stream >> name;
+
+        if (name == "depth")
+            stream >> engine.depth;
+        else if (name == "movetime")
+            stream >> engine.moveTime;
+        else if (name == "game")
+        {
+            std::string ggf;
+            std::getline(stream, ggf);
+            if (!setGame(engine, ggf, error))
+                fprintf(stderr, "engine: %s\n", error.c_str());
+        }
+        // "set contempt" and unknown settings are ignored
+    }
+    else if (command == "move")
+    {
+        std::string move;
+        stream >> move;
+        std::string lower = move.substr(0, 2);
+        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+
+        // A pass was made by the player who is no longer to move
+        Player player = engine.model.currentPlayer;
+        if (lower == "pa")
+            player = (player == PLAYER_BLACK) ? PLAYER_WHITE : PLAYER_BLACK;
+
+        if (!playGameMove(engine, move, player, error))
+            fprintf(stderr, "engine: %s\n", error.c_str());
+    }
+    else if (command == "go")
+        go(engine);
+    else if (command == "hint")
+    {
+        int count = 1;
+        stream >> count;
+        hint(engine, std::max(1, count));
+    }
+    else if (command == "analyze")
+        analyze(engine);
+    else
+        fprintf(stderr, "engine: unknown command %s\n", command.c_str());
+
+    fflush(stdout);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    initLog();
+    loadDefaultWeightFile();
+    loadDefaultBook();
+
+    Engine engine;
+    engine.threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t hashSize = TT_DEFAULT_SIZE_MB * 4;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *option = argv[i];
+        bool hasValue = (i + 1 < argc);
+
+        if (!strcmp(option, "--threads") && hasValue)
+            engine.threads = atoi(argv[++i]);
+        else if (!strcmp(option, "--hash") && hasValue)
+            hashSize = (size_t)atoi(argv[++i]);
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (engine.threads < 1 || hashSize < 1)
+    {
+        printUsage();
+        return 1;
+    }
+
+    // One table for the whole session, so moves reuse earlier searches
+    ttResize(hashSize);
+
+    initModel(engine.start);
+    startModel(engine.start);
+    engine.model = engine.start;
+
+    std::string line;
+    while (std::getline(std::cin, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+
+        if (!runCommand(engine, line))
+            break;
+    }
+
+    return 0;
+}
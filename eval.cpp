@@ -0,0 +1,467 @@
+/**
+ * @brief Implements the pattern-based evaluation function
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "eval.h"
+#include "bitops.h"
+#include "symmetry.h"
+
+/**
+ * @brief A pattern type, with its squares as seen from corner A1.
+ */
+struct PatternType
+{
+    const char *name;
+    int size;
+    int squares[EVAL_MAX_PATTERN_SIZE];
+};
+
+static const PatternType patternTypes[EVAL_PATTERN_TYPES] = {
+    {"edge2x", 10, {0, 1, 2, 3, 4, 5, 6, 7, 9, 14}},
+    {"corner2x5", 10, {0, 1, 2, 3, 4, 8, 9, 10, 11, 12}},
+    {"corner3x3", 9, {0, 1, 2, 8, 9, 10, 16, 17, 18}},
+    {"line2", 8, {8, 9, 10, 11, 12, 13, 14, 15}},
+    {"line3", 8, {16, 17, 18, 19, 20, 21, 22, 23}},
+    {"line4", 8, {24, 25, 26, 27, 28, 29, 30, 31}},
+    {"diag8", 8, {0, 9, 18, 27, 36, 45, 54, 63}},
+    {"diag7", 7, {1, 10, 19, 28, 37, 46, 55}},
+    {"diag6", 6, {2, 11, 20, 29, 38, 47}},
+    {"diag5", 5, {3, 12, 21, 30, 39}},
+    {"diag4", 4, {4, 13, 22, 31}},
+};
+
+// Valores "clásicos" de cada casilla, base de los pesos por defecto
+static const int squareValues[64] = {
+    100, -20, 10, 5, 5, 10, -20, 100,
+    -20, -50, -2, -2, -2, -2, -50, -20,
+    10, -2, -1, -1, -1, -1, -2, 10,
+    5, -2, -1, -1, -1, -1, -2, 5,
+    5, -2, -1, -1, -1, -1, -2, 5,
+    10, -2, -1, -1, -1, -1, -2, 10,
+    -20, -50, -2, -2, -2, -2, -50, -20,
+    100, -20, 10, 5, 5, 10, -20, 100,
+};
+
+static const uint64_t NOT_A_FILE = 0xFEFEFEFEFEFEFEFEULL;
+static const uint64_t NOT_H_FILE = 0x7F7F7F7F7F7F7F7FULL;
+
+// Patterns through each square, for incremental updates
+#define EVAL_MAX_SQUARE_PATTERNS 8
+
+struct SquarePattern
+{
+    int instance;
+    int power; // 3^k, k = position of the square in the pattern
+};
+
+static EvalPattern patterns[EVAL_PATTERN_INSTANCES];
+static int patternSymmetries[EVAL_PATTERN_INSTANCES]; // Maps each instance back to its type
+static SquarePattern squarePatterns[64][EVAL_MAX_SQUARE_PATTERNS];
+static int squarePatternCount[64];
+static int patternOffsets[EVAL_PATTERN_TYPES];
+static int stageSize;
+
+static std::vector<int16_t> defaultWeights;
+static const int16_t *evalWeights; // Defaults, or a mapped weight file
+
+static int pow3(int n)
+{
+    int result = 1;
+    while (n--)
+        result *= 3;
+    return result;
+}
+
+/**
+ * @brief Builds the pattern instances: each type under the 8 symmetries,
+ * without duplicate square sets.
+ */
+static void initPatterns()
+{
+    int count = 0;
+    int offset = 0;
+
+    for (int type = 0; type < EVAL_PATTERN_TYPES; type++)
+    {
+        const PatternType &patternType = patternTypes[type];
+        uint64_t seen[8];
+        int seenCount = 0;
+
+        for (int symmetry = 0; symmetry < SYMMETRY_COUNT; symmetry++)
+        {
+            EvalPattern pattern;
+            uint64_t mask = 0;
+
+            pattern.type = type;
+            pattern.size = patternType.size;
+            for (int k = 0; k < patternType.size; k++)
+            {
+                pattern.squares[k] = transformSquare(patternType.squares[k], symmetry);
+                mask |= 1ULL << pattern.squares[k];
+            }
+
+            bool duplicate = false;
+            for (int i = 0; i < seenCount; i++)
+                duplicate |= (seen[i] == mask);
+            if (duplicate || count >= EVAL_PATTERN_INSTANCES)
+                continue;
+
+            seen[seenCount++] = mask;
+            patternSymmetries[count] = inverseSymmetry(symmetry);
+            patterns[count++] = pattern;
+        }
+
+        patternOffsets[type] = offset;
+        offset += pow3(patternType.size);
+    }
+
+    // Mobility and potential mobility weights
+    stageSize = offset + 2;
+
+    for (int i = 0; i < count; i++)
+        for (int k = 0; k < patterns[i].size; k++)
+        {
+            int sq = patterns[i].squares[k];
+            SquarePattern &squarePattern = squarePatterns[sq][squarePatternCount[sq]++];
+            squarePattern.instance = i;
+            squarePattern.power = pow3(k);
+        }
+}
+
+/**
+ * @brief Builds hand-made default weights until tuned weights are loaded.
+ *
+ * Each pattern spreads the classic square values (scaled by stage) and a
+ * disc-count term over the instances covering every square. X and C squares
+ * next to an occupied corner lose their penalty, which a square table alone
+ * cannot express.
+ */
+static void buildDefaultWeights()
+{
+    int coverage[64] = {0};
+    for (int i = 0; i < EVAL_PATTERN_INSTANCES; i++)
+        for (int k = 0; k < patterns[i].size; k++)
+            coverage[patterns[i].squares[k]]++;
+
+    defaultWeights.assign(EVAL_STAGES * stageSize, 0);
+
+    for (int stage = 0; stage < EVAL_STAGES; stage++)
+    {
+        int16_t *weights = &defaultWeights[stage * stageSize];
+        double positionalScale = 3.0 - 2.0 * stage / (EVAL_STAGES - 1);
+        double discValue = (stage > 9) ? SCORE_DISC * (stage - 9) / 6.0 : 0;
+
+        for (int type = 0; type < EVAL_PATTERN_TYPES; type++)
+        {
+            const PatternType &patternType = patternTypes[type];
+            int16_t *table = weights + patternOffsets[type];
+            int size = pow3(patternType.size);
+
+            for (int index = 0; index < size; index++)
+            {
+                int digits[EVAL_MAX_PATTERN_SIZE];
+                for (int k = 0, n = index; k < patternType.size; k++, n /= 3)
+                    digits[k] = n % 3;
+
+                double value = 0;
+                for (int k = 0; k < patternType.size; k++)
+                {
+                    if (!digits[k])
+                        continue;
+
+                    int sq = patternType.squares[k];
+                    int row = sq / 8;
+                    int col = sq % 8;
+                    int corner = ((row < 4) ? 0 : 7) * 8 + ((col < 4) ? 0 : 7);
+                    double squareValue = squareValues[sq];
+
+                    if (squareValue < 0)
+                        for (int j = 0; j < patternType.size; j++)
+                            if (patternType.squares[j] == corner && digits[j])
+                                squareValue = 0;
+
+                    double cell = (squareValue * positionalScale + discValue) / coverage[sq];
+                    value += (digits[k] == 1) ? cell : -cell;
+                }
+
+                table[index] = (int16_t)floor(value + 0.5);
+            }
+        }
+
+        weights[stageSize - 2] = (int16_t)(40 - 2 * stage);
+        weights[stageSize - 1] = (int16_t)(15 - stage);
+    }
+
+    evalWeights = &defaultWeights[0];
+}
+
+static void computePatternIndicesScalar(uint64_t black, uint64_t white, int *indices)
+{
+    for (int i = 0; i < EVAL_PATTERN_INSTANCES; i++)
+    {
+        const EvalPattern &pattern = patterns[i];
+        int index = 0;
+
+        for (int k = pattern.size - 1; k >= 0; k--)
+        {
+            int sq = pattern.squares[k];
+            index = index * 3 + (int)((black >> sq) & 1) + 2 * (int)((white >> sq) & 1);
+        }
+
+        indices[i] = index;
+    }
+}
+
+#ifdef REVERSI_X86_64
+// Squares of each pattern type (all listed in ascending order), and base-3
+// values of their binary digits, for PEXT extraction
+static uint64_t patternTypeMasks[EVAL_PATTERN_TYPES];
+static uint16_t ternaryValues[1 << EVAL_MAX_PATTERN_SIZE];
+
+static void initPatternExtraction()
+{
+    for (int type = 0; type < EVAL_PATTERN_TYPES; type++)
+        for (int k = 0; k < patternTypes[type].size; k++)
+            patternTypeMasks[type] |= 1ULL << patternTypes[type].squares[k];
+
+    for (int bits = 0; bits < (1 << EVAL_MAX_PATTERN_SIZE); bits++)
+        for (int k = EVAL_MAX_PATTERN_SIZE - 1; k >= 0; k--)
+            ternaryValues[bits] = (uint16_t)(ternaryValues[bits] * 3 + ((bits >> k) & 1));
+}
+
+/**
+ * @brief Maps the board back through each instance's symmetry, so every
+ * instance of a type is one PEXT of the type's squares.
+ */
+REVERSI_TARGET("bmi2") static void computePatternIndicesBmi2(uint64_t black, uint64_t white,
+                                                             int *indices)
+{
+    uint64_t blacks[SYMMETRY_COUNT];
+    uint64_t whites[SYMMETRY_COUNT];
+    for (int symmetry = 0; symmetry < SYMMETRY_COUNT; symmetry++)
+    {
+        blacks[symmetry] = transformBoard(black, symmetry);
+        whites[symmetry] = transformBoard(white, symmetry);
+    }
+
+    for (int i = 0; i < EVAL_PATTERN_INSTANCES; i++)
+    {
+        uint64_t mask = patternTypeMasks[patterns[i].type];
+        int symmetry = patternSymmetries[i];
+
+        indices[i] = ternaryValues[extractBitsBmi2(blacks[symmetry], mask)] +
+                     2 * ternaryValues[extractBitsBmi2(whites[symmetry], mask)];
+    }
+}
+#endif
+
+static void (*computePatternIndicesKernel)(uint64_t, uint64_t, int *) =
+    computePatternIndicesScalar;
+
+static struct EvalInit
+{
+    EvalInit()
+    {
+        initPatterns();
+        buildDefaultWeights();
+
+#ifdef REVERSI_X86_64
+        initPatternExtraction();
+        if (getCpuFeatures().fastPext)
+            computePatternIndicesKernel = computePatternIndicesBmi2;
+#endif
+    }
+} evalInit;
+
+int getEvalStage(int discs)
+{
+    int stage = (discs - 4) / 4;
+
+    if (stage < 0)
+        return 0;
+    if (stage >= EVAL_STAGES)
+        return EVAL_STAGES - 1;
+    return stage;
+}
+
+const EvalPattern *getEvalPatterns()
+{
+    return patterns;
+}
+
+const char *getPatternName(int type)
+{
+    return patternTypes[type].name;
+}
+
+int getEvalStageSize()
+{
+    return stageSize;
+}
+
+int getPatternOffset(int type)
+{
+    return patternOffsets[type];
+}
+
+int getMobilityOffset()
+{
+    return stageSize - 2;
+}
+
+const int16_t *getEvalWeights()
+{
+    return evalWeights;
+}
+
+void setEvalWeights(const int16_t *weights)
+{
+    evalWeights = weights ? weights : &defaultWeights[0];
+}
+
+void computePatternIndices(uint64_t black, uint64_t white, int *indices)
+{
+    computePatternIndicesKernel(black, white, indices);
+}
+
+/**
+ * @brief Returns the squares adjacent to any disc of a bitboard.
+ */
+static inline uint64_t getNeighbours(uint64_t b)
+{
+    uint64_t h = ((b << 1) & NOT_A_FILE) | ((b >> 1) & NOT_H_FILE);
+    uint64_t row = b | h;
+
+    return h | (row << 8) | (row >> 8);
+}
+
+int getPotentialMobility(uint64_t me, uint64_t opp)
+{
+    uint64_t empty = ~(me | opp);
+
+    return popCount(empty & getNeighbours(opp)) - popCount(empty & getNeighbours(me));
+}
+
+void initEvalState(EvalState &state, const Position &position, const int16_t *weights)
+{
+    int indices[EVAL_PATTERN_INSTANCES];
+
+    computePatternIndices(position.black, position.white, indices);
+    for (int i = 0; i < EVAL_PATTERN_INSTANCES; i++)
+        state.indices[i] = (uint16_t)indices[i];
+    state.weights = weights ? weights : evalWeights;
+}
+
+void evalMakeMove(EvalState &state, Player player, int sq, uint64_t flips)
+{
+    // Empty -> player: +1 (black) or +2 (white) per digit
+    int placed = (player == PLAYER_BLACK) ? 1 : 2;
+    for (int i = 0; i < squarePatternCount[sq]; i++)
+        state.indices[squarePatterns[sq][i].instance] += placed * squarePatterns[sq][i].power;
+
+    // Opponent -> player: white (2) to black (1) is -1, black to white +1
+    int flipped = (player == PLAYER_BLACK) ? -1 : 1;
+    for (; flips; flips &= flips - 1)
+    {
+        int f = lowestSquare(flips);
+        for (int i = 0; i < squarePatternCount[f]; i++)
+            state.indices[squarePatterns[f][i].instance] += flipped * squarePatterns[f][i].power;
+    }
+}
+
+void evalUndoMove(EvalState &state, Player player, int sq, uint64_t flips)
+{
+    int placed = (player == PLAYER_BLACK) ? 1 : 2;
+    for (int i = 0; i < squarePatternCount[sq]; i++)
+        state.indices[squarePatterns[sq][i].instance] -= placed * squarePatterns[sq][i].power;
+
+    int flipped = (player == PLAYER_BLACK) ? -1 : 1;
+    for (; flips; flips &= flips - 1)
+    {
+        int f = lowestSquare(flips);
+        for (int i = 0; i < squarePatternCount[f]; i++)
+            state.indices[squarePatterns[f][i].instance] -= flipped * squarePatterns[f][i].power;
+    }
+}
+
+/**
+ * @brief Evaluates a position given its mobility (legal moves of the side
+ * to move minus the opponent's).
+ */
+static int evaluate(const Position &position, const EvalState &state, int mobility)
+{
+    uint64_t me = position.getPlayer();
+    uint64_t opp = position.getOpponent();
+
+    const int16_t *weights = state.weights + getEvalStage(popCount(me | opp)) * stageSize;
+
+    // Pattern tables score for black
+    int score = 0;
+    for (int i = 0; i < EVAL_PATTERN_INSTANCES; i++)
+        score += weights[patternOffsets[patterns[i].type] + state.indices[i]];
+    if (position.currentPlayer == PLAYER_WHITE)
+        score = -score;
+
+    int potentialMobility = getPotentialMobility(me, opp);
+
+    score += weights[stageSize - 2] * mobility +
+             weights[stageSize - 1] * potentialMobility;
+
+    if (score >= 64 * SCORE_DISC)
+        score = 64 * SCORE_DISC - 1;
+    else if (score <= -64 * SCORE_DISC)
+        score = -64 * SCORE_DISC + 1;
+
+    return score;
+}
+
+int evaluate(const Position &position, const EvalState &state)
+{
+    uint64_t me = position.getPlayer();
+    uint64_t opp = position.getOpponent();
+    int mobility = popCount(generateMoves(me, opp)) - popCount(generateMoves(opp, me));
+
+    return evaluate(position, state, mobility);
+}
+
+int evaluate(const Position &position)
+{
+    EvalState state;
+
+    initEvalState(state, position);
+    return evaluate(position, state);
+}
+
+void evaluateBatch(const Position *positions, size_t count, int *scores)
+{
+    // Both sides' moves of a chunk in one batched call
+    uint64_t me[2 * EVAL_BATCH_CHUNK];
+    uint64_t opp[2 * EVAL_BATCH_CHUNK];
+    uint64_t moves[2 * EVAL_BATCH_CHUNK];
+
+    for (size_t start = 0; start < count; start += EVAL_BATCH_CHUNK)
+    {
+        size_t n = std::min((size_t)EVAL_BATCH_CHUNK, count - start);
+        for (size_t i = 0; i < n; i++)
+        {
+            me[i] = opp[n + i] = positions[start + i].getPlayer();
+            opp[i] = me[n + i] = positions[start + i].getOpponent();
+        }
+        generateMovesBatch(me, opp, moves, 2 * n);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            EvalState state;
+            initEvalState(state, positions[start + i]);
+            int mobility = popCount(moves[i]) - popCount(moves[n + i]);
+            scores[start + i] = evaluate(positions[start + i], state, mobility);
+        }
+    }
+}
@@ -0,0 +1,196 @@
+/**
+ * @brief Implements the pattern-based evaluation function
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#ifndef EVAL_H
+#define EVAL_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "model.h"
+
+// Evaluation scores: 1 disc = 100 points
+#define SCORE_DISC 100
+
+// Game stages, by number of discs on the board
+#define EVAL_STAGES 16
+
+// Pattern types, and their instances over the 8 board symmetries
+#define EVAL_PATTERN_TYPES 11
+#define EVAL_PATTERN_INSTANCES 46
+#define EVAL_MAX_PATTERN_SIZE 10
+
+// Positions per batched move generation call in evaluateBatch
+#define EVAL_BATCH_CHUNK 64
+
+/**
+ * @brief A pattern instance: the squares whose ternary configuration
+ * (0 = empty, 1 = black, 2 = white; first square is the least significant
+ * digit) indexes the weight table of its type.
+ */
+struct EvalPattern
+{
+    int type;
+    int size;
+    int squares[EVAL_MAX_PATTERN_SIZE];
+};
+
+/**
+ * @brief Pattern indices of a position, updated incrementally by
+ * evalMakeMove/evalUndoMove alongside Position::makeMove/undoMove, and the
+ * weights that evaluate them.
+ */
+struct EvalState
+{
+    uint16_t indices[EVAL_PATTERN_INSTANCES];
+    const int16_t *weights;
+};
+
+/**
+ * @brief Returns the game stage for a number of discs.
+ *
+ * @param discs The number of discs on the board (4-64).
+ * @return The stage, 0 to EVAL_STAGES - 1.
+ */
+int getEvalStage(int discs);
+
+/**
+ * @brief Returns the pattern instances (EVAL_PATTERN_INSTANCES of them).
+ *
+ * @return The pattern instances.
+ */
+const EvalPattern *getEvalPatterns();
+
+/**
+ * @brief Returns the name of a pattern type.
+ *
+ * @param type The pattern type.
+ * @return The name.
+ */
+const char *getPatternName(int type);
+
+/**
+ * @brief Returns the number of weights per stage (pattern tables, then the
+ * mobility and potential mobility weights).
+ *
+ * @return The number of weights.
+ */
+int getEvalStageSize();
+
+/**
+ * @brief Returns the offset of a pattern type's table within a stage.
+ *
+ * @param type The pattern type.
+ * @return The offset, in weights.
+ */
+int getPatternOffset(int type);
+
+/**
+ * @brief Returns the offset of the mobility weight within a stage; the
+ * potential mobility weight follows it.
+ *
+ * @return The offset, in weights.
+ */
+int getMobilityOffset();
+
+/**
+ * @brief Returns the weights of all stages (EVAL_STAGES * stage size).
+ *
+ * @return The weights.
+ */
+const int16_t *getEvalWeights();
+
+/**
+ * @brief Switches the weights used by evaluate. Must not be called while a
+ * search is running.
+ *
+ * @param weights EVAL_STAGES * stage size weights, kept by the caller, or
+ * nullptr for the built-in default weights.
+ */
+void setEvalWeights(const int16_t *weights);
+
+/**
+ * @brief Computes the pattern indices of a position.
+ *
+ * @param black The black bitboard.
+ * @param white The white bitboard.
+ * @param indices Receives EVAL_PATTERN_INSTANCES indices.
+ */
+void computePatternIndices(uint64_t black, uint64_t white, int *indices);
+
+/**
+ * @brief Returns the potential mobility term of evaluate: empty squares
+ * next to the opponent's discs minus those next to the side to move's.
+ *
+ * @param me The side to move's discs.
+ * @param opp The opponent's discs.
+ * @return The potential mobility.
+ */
+int getPotentialMobility(uint64_t me, uint64_t opp);
+
+/**
+ * @brief Computes the pattern indices of a position from scratch.
+ *
+ * @param state The evaluation state.
+ * @param position The position.
+ * @param weights The weights to evaluate with (EVAL_STAGES * stage size),
+ * or nullptr for the current ones (see setEvalWeights). Lets engines with
+ * different weights search at the same time.
+ */
+void initEvalState(EvalState &state, const Position &position,
+                   const int16_t *weights = nullptr);
+
+/**
+ * @brief Updates the pattern indices for a move: only the patterns through
+ * the played square and the flipped discs change.
+ *
+ * @param state The evaluation state.
+ * @param player The player who moved.
+ * @param sq The square played.
+ * @param flips The flipped discs.
+ */
+void evalMakeMove(EvalState &state, Player player, int sq, uint64_t flips);
+
+/**
+ * @brief Reverts evalMakeMove.
+ *
+ * @param state The evaluation state.
+ * @param player The player who moved.
+ * @param sq The square played.
+ * @param flips The flipped discs.
+ */
+void evalUndoMove(EvalState &state, Player player, int sq, uint64_t flips);
+
+/**
+ * @brief Static evaluation of a position: pattern tables, mobility and
+ * potential mobility, with weights for the position's game stage.
+ *
+ * @param position The position.
+ * @param state The position's pattern indices.
+ * @return The score from the side to move's point of view.
+ */
+int evaluate(const Position &position, const EvalState &state);
+
+/**
+ * @brief Same as above, computing the pattern indices from scratch.
+ *
+ * @param position The position.
+ * @return The score from the side to move's point of view.
+ */
+int evaluate(const Position &position);
+
+/**
+ * @brief Evaluates many positions at once, e.g. for self-play or training
+ * data. The mobility of all positions comes from batched move generation.
+ *
+ * @param positions The positions.
+ * @param count The number of positions.
+ * @param scores Receives one score per position, as evaluate would.
+ */
+void evaluateBatch(const Position *positions, size_t count, int *scores);
+
+#endif
@@ -0,0 +1,232 @@
+/**
+ * @brief Headless driver: plays engine-vs-engine games without a window
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "model.h"
+#include "ai.h"
+#include "tt.h"
+#include "book.h"
+#include "weightfile.h"
+#include "log.h"
+
+/**
+ * @brief Plays random plies from the start position, for test positions.
+ *
+ * @return The plies played; fewer if the game ended first.
+ */
+static int playRandomPlies(GameModel &model, int plies)
+{
+    model.humanPlayer = PLAYER_BLACK;
+    startModel(model);
+
+    int ply = 0;
+    for (; ply < plies && !model.gameOver; ply++)
+    {
+        MoveList validMoves;
+        getValidMoves(model, validMoves, model.black, model.white);
+        playMove(model, validMoves.getSquare(rand() % validMoves.size()));
+    }
+
+    return ply;
+}
+
+static void printUsage()
+{
+    printf("usage: headless [games] [depth] [seed] [hash MB] [threads]\n"
+           "       headless smp [depth] [threads] [positions]\n"
+           "       headless endgame <empties> [positions] [wld]\n");
+}
+
+/**
+ * @brief Measures Lazy SMP time-to-depth speedup over a set of midgame
+ * positions: headless smp <depth> <threads> [positions].
+ */
+static int runSmpBenchmark(int depth, int threads, int positions)
+{
+    double time[2] = {0, 0};
+    uint64_t nodes[2] = {0, 0};
+    std::vector<uint64_t> threadNodes(threads, 0);
+
+    srand(1);
+    for (int i = 0; i < positions; i++)
+    {
+        GameModel model;
+        initModel(model);
+        playRandomPlies(model, 20 + rand() % 10);
+        if (model.gameOver)
+            continue;
+
+        for (int run = 0; run < 2; run++)
+        {
+            SearchLimits limits;
+            limits.maxDepth = depth;
+            limits.threads = run ? threads : 1;
+            limits.useBook = false;
+
+            ttClear();
+            SearchResult result = searchBestMove(model, limits);
+            time[run] += result.time;
+            nodes[run] += result.nodes;
+
+            // Endgame solves report only the main thread
+            if (run)
+                for (size_t j = 0; j < result.threadNodes.size() && j < threadNodes.size(); j++)
+                    threadNodes[j] += result.threadNodes[j];
+        }
+    }
+
+    printf("depth %d, %d positions\n", depth, positions);
+    printf("1 thread:   %.3f s  %llu nodes\n", time[0], (unsigned long long)nodes[0]);
+    printf("%d threads: %.3f s  %llu nodes\n", threads, time[1], (unsigned long long)nodes[1]);
+    for (int j = 0; j < threads; j++)
+        printf("  thread %d: %llu nodes\n", j, (unsigned long long)threadNodes[j]);
+    printf("speedup: %.2f\n", time[1] > 0 ? time[0] / time[1] : 0.0);
+
+    return 0;
+}
+
+/**
+ * @brief Times the endgame solver on random positions with a given number
+ * of empty squares: headless endgame <empties> [positions] [wld].
+ */
+static int runEndgameBenchmark(int empties, int positions, EndgameMode mode)
+{
+    double time = 0;
+    uint64_t nodes = 0;
+    int solved = 0;
+
+    srand(1);
+    while (solved < positions)
+    {
+        GameModel model;
+        initModel(model);
+        playRandomPlies(model, 60 - empties);
+        if (model.gameOver ||
+            getScore(model, PLAYER_BLACK) + getScore(model, PLAYER_WHITE) != 64 - empties)
+            continue;
+
+        SearchLimits limits;
+        limits.endgameEmpties = empties;
+        limits.endgameMode = mode;
+        limits.useBook = false;
+
+        ttClear();
+        SearchResult result = searchBestMove(model, limits);
+        time += result.time;
+        nodes += result.nodes;
+        solved++;
+
+        printf("%2d: %c%d  score %+3d  %10llu nodes  %.3f s\n", solved,
+               'a' + result.bestMove.y, result.bestMove.x + 1, result.score / SCORE_DISC,
+               (unsigned long long)result.nodes, result.time);
+    }
+
+    printf("%d empties, %s, %d positions: %.3f s/position, nodes/s: %.0f\n",
+           empties, (mode == ENDGAME_WLD) ? "WLD" : "exact", positions,
+           time / positions, time > 0 ? nodes / time : 0.0);
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    initLog();
+    loadDefaultWeightFile();
+    loadDefaultBook();
+
+    if (argc > 1 && !strcmp(argv[1], "smp"))
+    {
+        int depth = (argc > 2) ? atoi(argv[2]) : 10;
+        int threads = (argc > 3) ? atoi(argv[3]) : 4;
+        int positions = (argc > 4) ? atoi(argv[4]) : 20;
+        if (depth < 1 || threads < 1 || positions < 1)
+        {
+            printUsage();
+            return 1;
+        }
+
+        ttResize(TT_DEFAULT_SIZE_MB * 4);
+        return runSmpBenchmark(depth, threads, positions);
+    }
+
+    if (argc > 2 && !strcmp(argv[1], "endgame"))
+    {
+        int empties = atoi(argv[2]);
+        int positions = (argc > 3) ? atoi(argv[3]) : 10;
+        EndgameMode mode = (argc > 4 && !strcmp(argv[4], "wld")) ? ENDGAME_WLD : ENDGAME_EXACT;
+
+        ttResize(TT_DEFAULT_SIZE_MB * 4);
+        return runEndgameBenchmark(empties, positions, mode);
+    }
+
+    int games = (argc > 1) ? atoi(argv[1]) : 100;
+    int depth = (argc > 2) ? atoi(argv[2]) : 4;
+    unsigned int seed = (argc > 3) ? (unsigned int)atoi(argv[3]) : 1;
+    int hashSize = (argc > 4) ? atoi(argv[4]) : TT_DEFAULT_SIZE_MB;
+    int threads = (argc > 5) ? atoi(argv[5]) : 1;
+
+    // Random opening plies so that games differ
+    const int randomPlies = 4;
+
+    SearchLimits limits;
+    limits.maxDepth = depth;
+    limits.threads = threads;
+
+    srand(seed);
+    ttResize(hashSize);
+
+    int wins[2] = {0, 0};
+    int draws = 0;
+    long long moves = 0;
+    unsigned long long nodes = 0;
+
+    GameModel model;
+    initModel(model);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int game = 0; game < games; game++)
+    {
+        moves += playRandomPlies(model, randomPlies);
+
+        while (!model.gameOver)
+        {
+            SearchResult result = searchBestMove(model, limits);
+            nodes += result.nodes;
+
+            playMove(model, result.bestMove);
+            moves++;
+        }
+
+        int blackScore = getScore(model, PLAYER_BLACK);
+        int whiteScore = getScore(model, PLAYER_WHITE);
+
+        if (blackScore > whiteScore)
+            wins[PLAYER_BLACK]++;
+        else if (whiteScore > blackScore)
+            wins[PLAYER_WHITE]++;
+        else
+            draws++;
+    }
+
+    double elapsed = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+    printf("games: %d  black: %d  white: %d  draws: %d\n",
+           games, wins[PLAYER_BLACK], wins[PLAYER_WHITE], draws);
+    printf("moves: %lld  time: %.3f s  games/s: %.1f\n",
+           moves, elapsed, elapsed > 0 ? games / elapsed : 0.0);
+    printf("nodes: %llu  nodes/s: %.0f\n",
+           nodes, elapsed > 0 ? nodes / elapsed : 0.0);
+
+    return 0;
+}
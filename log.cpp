@@ -0,0 +1,222 @@
+/**
+ * @brief Implements the diagnostic log
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "log.h"
+
+/**
+ * @brief A ring buffer message. `sequence` is 2n + 1 while message n is
+ * being written and 2n + 2 once it is complete, so readers can detect
+ * torn or overwritten slots without locking writers out.
+ */
+struct LogSlot
+{
+    std::atomic<uint64_t> sequence;
+    double time;
+    int level;
+    char text[LOG_MESSAGE_SIZE];
+};
+
+static LogSlot logRing[LOG_RING_SIZE];
+static std::atomic<uint64_t> logHead(0);
+static std::atomic<int> consoleLevel(LOG_LEVEL_WARN);
+static std::atomic<bool> ringEnabled(false);
+
+static const char *const levelNames[] = {"trace", "debug", "info", "warn", "error", "off"};
+
+static double getLogTime()
+{
+    static const std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool isLogLevelEnabled(int level)
+{
+    return (level >= consoleLevel.load(std::memory_order_relaxed)) ||
+           ringEnabled.load(std::memory_order_relaxed);
+}
+
+void logMessage(int level, const char *format, ...)
+{
+    if (!isLogLevelEnabled(level))
+        return;
+
+    char text[LOG_MESSAGE_SIZE];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+
+    if (level >= consoleLevel.load(std::memory_order_relaxed))
+        fprintf(stderr, "%s: %s\n", levelNames[level], text);
+
+    if (ringEnabled.load(std::memory_order_relaxed))
+    {
+        uint64_t n = logHead.fetch_add(1, std::memory_order_relaxed);
+        LogSlot &slot = logRing[n & (LOG_RING_SIZE - 1)];
+
+        slot.sequence.store(2 * n + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.time = getLogTime();
+        slot.level = level;
+        memcpy(slot.text, text, sizeof(text));
+        slot.sequence.store(2 * n + 2, std::memory_order_release);
+    }
+}
+
+void setLogLevel(int level)
+{
+    consoleLevel.store(level, std::memory_order_relaxed);
+}
+
+void setLogRing(bool enabled)
+{
+    ringEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Appends up to maxLength characters of text to a line. Used instead
+ * of snprintf, which is not async-signal-safe.
+ */
+static size_t appendText(char *line, size_t length, size_t size, const char *text,
+                         size_t maxLength)
+{
+    for (size_t i = 0; i < maxLength && text[i] && length < size; i++)
+        line[length++] = text[i];
+
+    return length;
+}
+
+/**
+ * @brief Appends seconds as "%10.6f" prints them, digit by digit.
+ */
+static size_t appendTime(char *line, size_t length, size_t size, double time)
+{
+    uint64_t micros = (time > 0) ? (uint64_t)(time * 1e6 + 0.5) : 0;
+    char digits[24];
+    int count = 0;
+
+    // Least significant first, at least "0.000000"
+    do
+    {
+        digits[count++] = (char)('0' + micros % 10);
+        micros /= 10;
+    } while (micros || count < 7);
+
+    for (int i = count + 1; i < 10 && length < size; i++)
+        line[length++] = ' ';
+    for (int i = count - 1; i >= 0 && length < size; i--)
+    {
+        line[length++] = digits[i];
+        if (i == 6 && length < size)
+            line[length++] = '.';
+    }
+
+    return length;
+}
+
+/**
+ * @brief Writes the ring to a file descriptor. Lines are built by hand and
+ * written with write(), so it can run from a signal handler.
+ */
+static void dumpLog(int fd)
+{
+    uint64_t head = logHead.load(std::memory_order_acquire);
+    uint64_t first = (head > LOG_RING_SIZE) ? head - LOG_RING_SIZE : 0;
+
+    for (uint64_t n = first; n < head; n++)
+    {
+        LogSlot &slot = logRing[n & (LOG_RING_SIZE - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != 2 * n + 2)
+            continue;
+
+        // "[time] level: text\n"; the last byte is kept for the newline
+        char line[LOG_MESSAGE_SIZE + 32];
+        size_t size = sizeof(line) - 1;
+        int level = slot.level;
+        size_t length = appendText(line, 0, size, "[", 1);
+        length = appendTime(line, length, size, slot.time);
+        length = appendText(line, length, size, "] ", 2);
+        length = appendText(line, length, size,
+                            levelNames[(level >= 0 && level < LOG_LEVEL_OFF) ? level : 0],
+                            size);
+        length = appendText(line, length, size, ": ", 2);
+        length = appendText(line, length, size, slot.text, LOG_MESSAGE_SIZE);
+        line[length++] = '\n';
+
+        // Overwritten while it was being copied
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != 2 * n + 2)
+            continue;
+
+#ifdef _WIN32
+        _write(fd, line, (unsigned)length);
+#else
+        ssize_t written = write(fd, line, (size_t)length);
+        (void)written;
+#endif
+    }
+}
+
+void dumpLog(FILE *file)
+{
+    fflush(file);
+#ifdef _WIN32
+    dumpLog(_fileno(file));
+#else
+    dumpLog(fileno(file));
+#endif
+}
+
+static void handleCrash(int signal)
+{
+    static const char header[] = "\ncrashed, last log messages:\n";
+#ifdef _WIN32
+    _write(2, header, sizeof(header) - 1);
+#else
+    ssize_t written = write(2, header, sizeof(header) - 1);
+    (void)written;
+#endif
+    dumpLog(2);
+
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
+}
+
+void initLog()
+{
+    const char *level = getenv("REVERSI_LOG");
+    if (level)
+        for (int i = 0; i <= LOG_LEVEL_OFF; i++)
+            if (!strcmp(level, levelNames[i]))
+                setLogLevel(i);
+
+    const char *ring = getenv("REVERSI_LOG_RING");
+    if (ring && !strcmp(ring, "1"))
+    {
+        setLogRing(true);
+
+        std::signal(SIGSEGV, handleCrash);
+        std::signal(SIGABRT, handleCrash);
+        std::signal(SIGFPE, handleCrash);
+        std::signal(SIGILL, handleCrash);
+    }
+}
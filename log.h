@@ -0,0 +1,126 @@
+/**
+ * @brief Implements the diagnostic log
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <cstdio>
+
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_WARN 3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_OFF 5
+
+/*
+ * Levels below REVERSI_LOG_LEVEL are removed at compile time, arguments
+ * included. Release builds keep info and up; debug builds keep everything.
+ */
+#ifndef REVERSI_LOG_LEVEL
+#ifdef NDEBUG
+#define REVERSI_LOG_LEVEL LOG_LEVEL_INFO
+#else
+#define REVERSI_LOG_LEVEL LOG_LEVEL_TRACE
+#endif
+#endif
+
+// Messages longer than this are truncated
+#define LOG_MESSAGE_SIZE 120
+
+// Ring buffer slots (power of two)
+#define LOG_RING_SIZE 1024
+
+#define LOG_DISCARD(...) \
+    do                   \
+    {                    \
+    } while (0)
+
+#if REVERSI_LOG_LEVEL <= LOG_LEVEL_TRACE
+#define LOG_TRACE(...) logMessage(LOG_LEVEL_TRACE, __VA_ARGS__)
+#else
+#define LOG_TRACE(...) LOG_DISCARD(__VA_ARGS__)
+#endif
+
+#if REVERSI_LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) logMessage(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) LOG_DISCARD(__VA_ARGS__)
+#endif
+
+#if REVERSI_LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) logMessage(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) LOG_DISCARD(__VA_ARGS__)
+#endif
+
+#if REVERSI_LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(...) logMessage(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) LOG_DISCARD(__VA_ARGS__)
+#endif
+
+#if REVERSI_LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) logMessage(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) LOG_DISCARD(__VA_ARGS__)
+#endif
+
+/**
+ * @brief Whether a compiled-in level would be recorded, to skip building
+ * expensive arguments.
+ */
+#define LOG_ENABLED(level) ((level) >= REVERSI_LOG_LEVEL && isLogLevelEnabled(level))
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LOG_PRINTF_FORMAT __attribute__((format(printf, 2, 3)))
+#else
+#define LOG_PRINTF_FORMAT
+#endif
+
+/**
+ * @brief Records a message: printed to stderr from the console level up,
+ * and kept in the ring buffer if enabled. Thread-safe; use the LOG_ macros
+ * instead of calling it directly.
+ *
+ * @param level The level.
+ * @param format A printf format.
+ */
+void logMessage(int level, const char *format, ...) LOG_PRINTF_FORMAT;
+
+/**
+ * @brief Whether messages of a level are printed or kept at runtime.
+ */
+bool isLogLevelEnabled(int level);
+
+/**
+ * @brief Sets the lowest level printed to stderr (default: warn).
+ */
+void setLogLevel(int level);
+
+/**
+ * @brief Keeps every compiled-in message, whatever the console level, in a
+ * lock-free in-memory ring of the last LOG_RING_SIZE messages.
+ */
+void setLogRing(bool enabled);
+
+/**
+ * @brief Writes the ring buffer, oldest first. Messages being written
+ * concurrently are skipped.
+ *
+ * @param file The output file.
+ */
+void dumpLog(FILE *file);
+
+/**
+ * @brief Reads REVERSI_LOG (trace, debug, info, warn, error, off) for the
+ * console level and REVERSI_LOG_RING=1 to enable the ring buffer, which is
+ * then dumped to stderr on a crash.
+ */
+void initLog();
+
+#endif
@@ -1,11 +1,22 @@
+#include "raylib.h"
+
 #include "model.h"
 #include "view.h"
 #include "controller.h"
+#include "book.h"
+#include "tt.h"
+#include "weightfile.h"
+#include "log.h"
 
 int main()
 {
     GameModel model;
 
+    initLog();
+    setModelClock(GetTime);
+    loadDefaultWeightFile();
+    loadDefaultBook();
+    ttResize(TT_DEFAULT_SIZE_MB);
     initModel(model);
     initView();
 
@@ -0,0 +1,103 @@
+/**
+ * @brief Implements read-only memory-mapped files
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mappedfile.h"
+
+bool mapFile(const char *path, MappedFile &mappedFile)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || !size.QuadPart)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    const void *data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!data)
+    {
+        if (mapping)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    mappedFile.data = (const uint8_t *)data;
+    mappedFile.size = (size_t)size.QuadPart;
+    mappedFile.file = file;
+    mappedFile.mapping = mapping;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) || !st.st_size)
+    {
+        close(fd);
+        return false;
+    }
+
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid after closing the descriptor
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+
+    mappedFile.data = (const uint8_t *)data;
+    mappedFile.size = (size_t)st.st_size;
+#endif
+
+    return true;
+}
+
+void unmapFile(MappedFile &mappedFile)
+{
+    if (!mappedFile.data)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(mappedFile.data);
+    CloseHandle(mappedFile.mapping);
+    CloseHandle(mappedFile.file);
+#else
+    munmap((void *)mappedFile.data, mappedFile.size);
+#endif
+
+    mappedFile = MappedFile();
+}
+
+uint64_t getChecksum(const void *data, size_t size)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    uint64_t hash = 0xCBF29CE484222325ULL;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ULL;
+    }
+
+    return hash;
+}
@@ -0,0 +1,57 @@
+/**
+ * @brief Implements read-only memory-mapped files
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _WIN32
+typedef void *MappedFileHandle;
+#endif
+
+/**
+ * @brief A read-only file mapping. Processes mapping the same file share
+ * one page cache copy.
+ */
+struct MappedFile
+{
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    MappedFileHandle file = nullptr;
+    MappedFileHandle mapping = nullptr;
+#endif
+};
+
+/**
+ * @brief Maps a whole file read-only.
+ *
+ * @param path The file path.
+ * @param mappedFile Receives the mapping.
+ * @return Whether the file was mapped (empty files are not).
+ */
+bool mapFile(const char *path, MappedFile &mappedFile);
+
+/**
+ * @brief Checksum (64-bit FNV-1a) for the data of mapped file formats.
+ *
+ * @param data The data.
+ * @param size The size in bytes.
+ * @return The checksum.
+ */
+uint64_t getChecksum(const void *data, size_t size);
+
+/**
+ * @brief Unmaps a file. Does nothing if it is not mapped.
+ *
+ * @param mappedFile The mapping.
+ */
+void unmapFile(MappedFile &mappedFile);
+
+#endif
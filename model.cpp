@@ -5,25 +5,82 @@
  * @copyright Copyright (c) 2023-2024
  */
 
-#include "raylib.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 
 #include "model.h"
-#include <iostream>
+#include "bitops.h"
+#include "log.h"
+#include "model_avx2.h"
 #include <cstdint>
 
-#include <iostream>
-#include <bitset>
-#include <cstdint>
-using namespace std;
-
 const uint64_t NOT_A_FILE = 0xFEFEFEFEFEFEFEFEULL; // columna izquierda
 const uint64_t NOT_H_FILE = 0x7F7F7F7F7F7F7F7FULL; // columna derecha+
 
+/**
+ * @brief Default model clock: seconds elapsed on a monotonic clock.
+ */
+static double getMonotonicTime()
+{
+    static const std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static ModelClock modelClock = getMonotonicTime;
+
+uint64_t zobristSquare[2][64];
+uint64_t zobristFlip[8][256];
+uint64_t zobristSide;
+
+/**
+ * @brief Fills the Zobrist tables with fixed pseudo-random keys (splitmix64),
+ * so hashes are reproducible across runs and processes.
+ */
+static struct ZobristInit
+{
+    ZobristInit()
+    {
+        uint64_t state = 0x45444176657273ULL;
+
+        for (int p = 0; p < 2; p++)
+            for (int sq = 0; sq < 64; sq++)
+                zobristSquare[p][sq] = next(state);
+        zobristSide = next(state);
+
+        for (int row = 0; row < 8; row++)
+            for (int bits = 0; bits < 256; bits++)
+            {
+                uint64_t key = 0ULL;
+                for (int col = 0; col < 8; col++)
+                    if (bits & (1 << col))
+                        key ^= zobristSquare[PLAYER_BLACK][row * 8 + col] ^
+                               zobristSquare[PLAYER_WHITE][row * 8 + col];
+                zobristFlip[row][bits] = key;
+            }
+    }
+
+    static uint64_t next(uint64_t &state)
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+} zobristInit;
+
+void setModelClock(ModelClock clock)
+{
+    modelClock = clock ? clock : getMonotonicTime;
+}
 
 
 void initModel(GameModel& model)
 {
     model.gameOver = true;
+    model.currentPlayer = PLAYER_BLACK;
 
     model.playerTime[0] = 0;
     model.playerTime[1] = 0;
@@ -34,6 +91,7 @@ void initModel(GameModel& model)
 			model.removePiece(pos);
         }
     }
+    model.hash = 0ULL;
 }
 
 void startModel(GameModel& model)
@@ -44,7 +102,7 @@ void startModel(GameModel& model)
 
     model.playerTime[0] = 0;
     model.playerTime[1] = 0;
-    model.turnTimer = GetTime();
+    model.turnTimer = modelClock();
 
     for (int x = 0; x < BOARD_SIZE; x++) {
         for (int y = 0; y < BOARD_SIZE; y++) {
@@ -52,6 +110,7 @@ void startModel(GameModel& model)
             model.removePiece(pos);
         }
     }
+    model.hash = 0ULL;
 
 	model.placePiece(PLAYER_WHITE, BOARD_SIZE / 2 * BOARD_SIZE + BOARD_SIZE / 2);
 	model.placePiece(PLAYER_WHITE, (BOARD_SIZE / 2 - 1) * BOARD_SIZE + (BOARD_SIZE / 2 - 1));
@@ -76,19 +135,7 @@ void setBoardPiece(GameModel& model, Player player, int pos)
 
 int getScore(GameModel &model, Player player)
 {
-    int score = 0;
-
-    for (int x = 0; x < BOARD_SIZE; x++) 
-        for (int y = 0; y < BOARD_SIZE; y++) {
-            int pos = x * 8 + y;
-            if (((model.hasPiece(PLAYER_WHITE, pos)) && (player == PLAYER_WHITE)) ||
-                ((model.hasPiece(PLAYER_BLACK, pos)) && (player == PLAYER_BLACK))) {
-                score++;
-            }
-
-        }
-
-    return score;
+    return popCount((player == PLAYER_BLACK) ? model.black : model.white);
 }
 
 double getTimer(GameModel &model, Player player)
@@ -96,7 +143,7 @@ double getTimer(GameModel &model, Player player)
     double turnTime = 0;
 
     if (!model.gameOver && (player == model.currentPlayer))
-        turnTime = GetTime() - model.turnTimer;
+        turnTime = modelClock() - model.turnTimer;
 
     return model.playerTime[player] + turnTime;
 }
@@ -109,231 +156,257 @@ bool isSquareValid(Square square)
            (square.y < BOARD_SIZE);
 }
 
-int ctz64_simple(uint64_t x) {
-    int count = 0;
-    while (x && (x & 1) == 0) {
-        x >>= 1;
-        count++;
+#if REVERSI_LOG_LEVEL <= LOG_LEVEL_TRACE
+/**
+ * @brief Logs a bitboard as an 8x8 grid, row 1 first.
+ */
+static void logBoard(const char *name, uint64_t board)
+{
+    LOG_TRACE("%s:", name);
+    for (int row = 0; row < 8; row++) {
+        char line[9];
+        for (int col = 0; col < 8; col++)
+            line[col] = ((board >> (row * 8 + col)) & 1) ? 'X' : '.';
+        line[8] = '\0';
+        LOG_TRACE("  %d %s", row + 1, line);
     }
-    return count;
 }
+#endif
 
-void check_if_legal(uint64_t a, uint64_t &b) {
+/**
+ * @brief Kogge-Stone fill of the opponent discs adjacent to `gen` in one
+ * direction (positive shift). `o` must already carry the wrap-around mask.
+ */
+static inline uint64_t fillLeft(uint64_t gen, uint64_t o, int shift)
+{
+    uint64_t flip = o & (gen << shift);
+    flip |= o & (flip << shift);
+    uint64_t pre = o & (o << shift);
+    flip |= pre & (flip << (2 * shift));
+    flip |= pre & (flip << (2 * shift));
+    return flip;
+}
 
-    if (a == 1 || a == 9 || a == -7) {
-        b &= NOT_H_FILE;
-    }
-    if (a == -1 || a == 7 || a == -9) {
-        b &= NOT_A_FILE;
-    }
+/**
+ * @brief Same as fillLeft, for the opposite direction (negative shift).
+ */
+static inline uint64_t fillRight(uint64_t gen, uint64_t o, int shift)
+{
+    uint64_t flip = o & (gen >> shift);
+    flip |= o & (flip >> shift);
+    uint64_t pre = o & (o >> shift);
+    flip |= pre & (flip >> (2 * shift));
+    flip |= pre & (flip >> (2 * shift));
+    return flip;
+}
 
+static uint64_t generateMovesScalar(uint64_t me, uint64_t opp)
+{
+    // Horizontal y diagonales no pueden cruzar el borde: se enmascaran las
+    // columnas A y H del rival, así la cadena nunca "da la vuelta".
+    uint64_t inner = opp & NOT_A_FILE & NOT_H_FILE;
+    uint64_t moves;
+
+    moves = fillLeft(me, inner, 1) << 1;    // Este
+    moves |= fillRight(me, inner, 1) >> 1;  // Oeste
+    moves |= fillLeft(me, opp, 8) << 8;     // Sur
+    moves |= fillRight(me, opp, 8) >> 8;    // Norte
+    moves |= fillLeft(me, inner, 7) << 7;   // Suroeste
+    moves |= fillRight(me, inner, 7) >> 7;  // Noreste
+    moves |= fillLeft(me, inner, 9) << 9;   // Sureste
+    moves |= fillRight(me, inner, 9) >> 9;  // Noroeste
+
+    return moves & ~(me | opp);
 }
 
-void printBoard(uint64_t board) {
-    std::cout << "\nBitboard visualization:\n";
-    std::cout << "  0 1 2 3 4 5 6 7\n";
-    std::cout << "  ---------------\n";
+void getValidMoves(GameModel& model, MoveList& validMoves, uint64_t black_board, uint64_t white_board)
+{
+    validMoves.clear();
 
-    for (int row = 0; row < 8; row++) {
-        std::cout << row << "|";
-        for (int col = 0; col < 8; col++) {
-            int index = row * 8 + col;
-            uint64_t bit = 1ULL << index;
-            std::cout << ((board & bit) ? "X " : ". ");
-        }
-        std::cout << "| (ndices " << row * 8 << "-" << (row * 8 + 7) << ")\n";
+    uint64_t validBits = (getCurrentPlayer(model) == PLAYER_BLACK)
+        ? generateMoves(black_board, white_board)
+        : generateMoves(white_board, black_board);
+
+    while (validBits) {
+        int index = popLowestSquare(validBits); // índice del bit menos significativo que está a 1
+        LOG_TRACE("valid move: %c%d", 'a' + index % 8, index / 8 + 1);
+        validMoves.add(index);
     }
-    std::cout << "  ---------------\n";
 }
 
 
-void getValidMoves(GameModel& model, Moves& validMoves, uint64_t black_board, uint64_t white_board)
+static uint64_t computeFlipsScalar(uint64_t me, uint64_t opp, int sq)
 {
-    validMoves.clear();
-    // direcciones: desplazamientos en el tablero
-    int directions[8] = {
-    1,   // Este ()      - derecha
-    -1,  // Oeste ()     - izquierda
-    8,   // Sur ()       - abajo
-    -8,  // Norte      - arriba
-    7,   // Suroeste  - diagonal abajo-izquierda
-    -7,  // Noreste    - diagonal arriba-derecha
-    9,   // Sureste   - diagonal abajo-derecha
-    -9   // Noroeste   - diagonal arriba-izquierda
-    };
-    uint64_t empty = ~(black_board | white_board); // casillas vacas
-    uint64_t prev_mask = 0ULL;
-    uint64_t validBits = 0ULL;
-    uint64_t myBoard = 0ULL;
-    uint64_t opponentBoard = 0ULL;
-    if (getCurrentPlayer(model) == PLAYER_BLACK) {
-        myBoard = black_board;
-        opponentBoard = white_board;
-    }
-    else
+    uint64_t move = 1ULL << sq;
+    uint64_t inner = opp & NOT_A_FILE & NOT_H_FILE;
+    uint64_t flips = 0ULL;
+    uint64_t run;
+
+    // Cada dirección: cadena de fichas rivales desde `sq`, válida solo si
+    // la casilla siguiente es propia.
+    run = fillLeft(move, inner, 1);
+    flips |= run & (0ULL - (uint64_t)(((run << 1) & me) != 0));
+    run = fillRight(move, inner, 1);
+    flips |= run & (0ULL - (uint64_t)(((run >> 1) & me) != 0));
+    run = fillLeft(move, opp, 8);
+    flips |= run & (0ULL - (uint64_t)(((run << 8) & me) != 0));
+    run = fillRight(move, opp, 8);
+    flips |= run & (0ULL - (uint64_t)(((run >> 8) & me) != 0));
+    run = fillLeft(move, inner, 7);
+    flips |= run & (0ULL - (uint64_t)(((run << 7) & me) != 0));
+    run = fillRight(move, inner, 7);
+    flips |= run & (0ULL - (uint64_t)(((run >> 7) & me) != 0));
+    run = fillLeft(move, inner, 9);
+    flips |= run & (0ULL - (uint64_t)(((run << 9) & me) != 0));
+    run = fillRight(move, inner, 9);
+    flips |= run & (0ULL - (uint64_t)(((run >> 9) & me) != 0));
+
+    return flips;
+}
+
+static void generateMovesBatchScalar(const uint64_t *me, const uint64_t *opp, uint64_t *moves,
+                                     size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        moves[i] = generateMovesScalar(me[i], opp[i]);
+}
+
+static MoveGenerator moveGenerator = MOVEGEN_SCALAR;
+static uint64_t (*generateMovesKernel)(uint64_t, uint64_t) = generateMovesScalar;
+static uint64_t (*computeFlipsKernel)(uint64_t, uint64_t, int) = computeFlipsScalar;
+static void (*generateMovesBatchKernel)(const uint64_t *, const uint64_t *, uint64_t *,
+                                        size_t) = generateMovesBatchScalar;
+
+bool setMoveGenerator(MoveGenerator generator)
+{
+    switch (generator)
     {
-        myBoard = white_board;
-        opponentBoard = black_board;
+    case MOVEGEN_SCALAR:
+        generateMovesKernel = generateMovesScalar;
+        computeFlipsKernel = computeFlipsScalar;
+        generateMovesBatchKernel = generateMovesBatchScalar;
+        break;
+
+#ifdef REVERSI_X86_64
+    case MOVEGEN_AVX2:
+        if (!getCpuFeatures().avx2)
+            return false;
+        generateMovesKernel = generateMovesAvx2;
+        computeFlipsKernel = computeFlipsAvx2;
+        generateMovesBatchKernel = generateMovesBatchAvx2;
+        break;
+#endif
+
+    default:
+        return false;
     }
 
-    for(int i = 0; i < 8; i++) {
-        int direction = directions[i];
-        uint64_t mask = direction > 0 ? (myBoard << direction) : (myBoard >> (-direction));
-		//check_if_legal(direction, mask);
-        int count = 1;
-        uint64_t candidates = 0ULL;
-        mask &= opponentBoard;
-        //printBoard(mask);
-        while (mask){
-            prev_mask = mask;
-            mask = direction > 0 ? (mask << (direction)) : (mask >> (-(direction)));
-			check_if_legal(direction, mask);
-          //  printBoard(mask);
-            candidates = mask;
-            validBits |= candidates & empty;
-            mask &= opponentBoard;
-            count++;
-        }
+    moveGenerator = generator;
+    return true;
+}
 
-		//printBoard(candidates);
-        validBits |= candidates & empty;
-	}
-    //ME FALTARA SOLO ARREGLAR LOS CASOS LMITES
-    while (validBits) {
-       // printBoard(validBits);
-        uint64_t index = ctz64_simple(validBits); // ndice del bit menos significativo que est a 1
-        validBits &= validBits - 1ULL;
-        int fila = index / 8; // fila
-        int columna = index % 8; // coumna
-        cout << "Valid move: " << fila << "," << columna<< endl;
-        Square move = { fila, columna, index };
-        validMoves.push_back(move);
-    }
+MoveGenerator getMoveGenerator()
+{
+    return moveGenerator;
 }
 
+const char *getMoveGeneratorName(MoveGenerator generator)
+{
+    return (generator == MOVEGEN_AVX2) ? "avx2" : "scalar";
+}
 
-bool playMove(GameModel& model, Square move)
+/**
+ * @brief Selects the fastest move generator the CPU supports.
+ */
+static struct MoveGeneratorInit
 {
-    vector<int> piezas_comidas;
-    vector<int> piezas_potencial;
-    // Set game piece
-    Piece piece =
-        (getCurrentPlayer(model) == PLAYER_WHITE)
-        ? PIECE_WHITE
-        : PIECE_BLACK;
-    cout << "Move played: " << move.x << "," << move.y << endl;
-    uint64_t pos = move.x * 8 + move.y;
-    cout << pos << endl;
-    uint64_t myBoard = 0ULL;
-    uint64_t opponentBoard = 0ULL;
-    uint64_t piezas_posibles = 0ULL;
-
-    setBoardPiece(model, getCurrentPlayer(model), pos);
-
-    int directions[8] = {
-    1,   // Este ()      - derecha
-    -1,  // Oeste ()     - izquierda
-    8,   // Sur ()       - abajo
-    -8,  // Norte      - arriba
-    7,   // Suroeste  - diagonal abajo-izquierda
-    -7,  // Noreste    - diagonal arriba-derecha
-    9,   // Sureste   - diagonal abajo-derecha
-    -9   // Noroeste   - diagonal arriba-izquierda
-    }; if (getCurrentPlayer(model) == PLAYER_BLACK) {
-        myBoard = model.black;
-        opponentBoard = model.white;
-    }
-    else
+    MoveGeneratorInit()
     {
-        myBoard = model.white;
-        opponentBoard = model.black;
+        const char *forced = getenv("REVERSI_MOVEGEN");
+        if (!forced || strcmp(forced, "scalar"))
+            setMoveGenerator(MOVEGEN_AVX2);
     }
+} moveGeneratorInit;
 
-    int longitud = 0;
-
-    for (int i = 0; i < 8; i++) {
-        int direction = directions[i];
-        uint64_t mask = 0ULL;
-        uint64_t piezas_potenciales = 0ULL;
-        mask = 1ULL << pos;
-        mask = direction > 0 ? (mask << direction) : (mask >> (-direction));
-        uint64_t mask_enemy = mask & opponentBoard;
-        uint64_t mask_own = mask & myBoard;
-        bool potencial_pieza = false;
-        while (mask_enemy || mask_own) {
-            if (mask_enemy != 0) {
-                piezas_potenciales |= mask_enemy;
-                uint64_t index = ctz64_simple(piezas_potenciales); // ndice del bit menos significativo que est a 1
-                int fila = index / 8; // fila
-                int columna = index % 8; // columna
-                potencial_pieza = true;
-            }
-            else if (mask_own != 0 && potencial_pieza) {
-                while (piezas_potenciales) {
-                    uint64_t index = ctz64_simple(piezas_potenciales); // ndice del bit menos significativo que est a 1
-                    piezas_potenciales &= piezas_potenciales - 1ULL;
-                    int fila = index / 8; // fila
-                    int columna = index % 8; // coumna
-                    piezas_comidas.push_back(fila * 8 + columna);
-                    longitud++;
-
-                }
-                potencial_pieza = false;
-                break;
-            }
-            mask = direction > 0 ? (mask << direction) : (mask >> (-direction));
-            mask_enemy = mask & opponentBoard;
-            mask_own = mask & myBoard;
-        }
-    }
+uint64_t generateMoves(uint64_t me, uint64_t opp)
+{
+    return generateMovesKernel(me, opp);
+}
 
-    for (int i = 0; i < longitud; i++) {
-        setBoardPiece(model, getCurrentPlayer(model), piezas_comidas[i]);
-    }
+uint64_t computeFlips(uint64_t me, uint64_t opp, int sq)
+{
+    return computeFlipsKernel(me, opp, sq);
+}
 
-    if (getCurrentPlayer(model) == PLAYER_BLACK) {
-        myBoard = model.black;
-        opponentBoard = model.white;
-    }
-    else
-    {
-        myBoard = model.white;
-        opponentBoard = model.black;
+void generateMovesBatch(const uint64_t *me, const uint64_t *opp, uint64_t *moves, size_t count)
+{
+    generateMovesBatchKernel(me, opp, moves, count);
+}
+
+uint64_t computeHash(uint64_t black, uint64_t white, Player currentPlayer)
+{
+    uint64_t hash = (currentPlayer == PLAYER_WHITE) ? zobristSide : 0ULL;
+
+    for (uint64_t b = black; b;)
+        hash ^= zobristSquare[PLAYER_BLACK][popLowestSquare(b)];
+    for (uint64_t w = white & ~black; w;)
+        hash ^= zobristSquare[PLAYER_WHITE][popLowestSquare(w)];
+
+    return hash;
+}
+
+Position getPosition(GameModel &model)
+{
+    Position position;
+
+    position.black = model.black;
+    position.white = model.white;
+    position.currentPlayer = model.currentPlayer;
+    position.hash = model.hash;
+
+    return position;
+}
+
+bool playMove(GameModel& model, Square move)
+{
+    int pos = move.x * 8 + move.y;
+
+    if (!isSquareValid(move) || ((model.black | model.white) & (1ULL << pos)))
+        return false;
+
+    Position position = getPosition(model);
+    if (!position.makeMove(pos))
+        return false;
+
+    LOG_DEBUG("move played: %c%d", 'a' + move.y, move.x + 1);
+#if REVERSI_LOG_LEVEL <= LOG_LEVEL_TRACE
+    if (LOG_ENABLED(LOG_LEVEL_TRACE)) {
+        logBoard("black", position.black);
+        logBoard("white", position.white);
     }
-	printBoard(myBoard);
-    printBoard(opponentBoard);
-    // To-do: your code goes here...
-    myBoard = model.black;
-    opponentBoard = model.white;
+#endif
 
+    model.black = position.black;
+    model.white = position.white;
+    model.hash = position.hash;
 
     // Update timer
-    double currentTime = GetTime();
+    double currentTime = modelClock();
     model.playerTime[model.currentPlayer] += currentTime - model.turnTimer;
     model.turnTimer = currentTime;
 
     // Swap player
-    model.currentPlayer =
-        (model.currentPlayer == PLAYER_WHITE)
-            ? PLAYER_BLACK
-            : PLAYER_WHITE;
+    model.currentPlayer = position.currentPlayer;
 
     // Game over?
-    Moves validMoves;
-    getValidMoves(model, validMoves, model.black, model.white);
-
-    if (validMoves.size() == 0)
+    if (!position.getMoves())
     {
-        // Swap player
-        model.currentPlayer =
-            (model.currentPlayer == PLAYER_WHITE)
-                ? PLAYER_BLACK
-                : PLAYER_WHITE;
-
-        Moves validMoves;
-        getValidMoves(model, validMoves, model.black, model.white);
+        // Pass
+        position.passMove();
+        model.currentPlayer = position.currentPlayer;
+        model.hash = position.hash;
 
-        if (validMoves.size() == 0)
+        if (!position.getMoves())
             model.gameOver = true;
     }
 
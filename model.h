@@ -8,6 +8,7 @@
 #ifndef MODEL_H
 #define MODEL_H
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
@@ -38,6 +39,27 @@ struct Square
         -1, -1              \
     }
 
+// Claves Zobrist (se inicializan en model.cpp)
+extern uint64_t zobristSquare[2][64];   // ficha de un jugador en una casilla
+extern uint64_t zobristFlip[8][256];    // fichas volteadas, por byte del bitboard
+extern uint64_t zobristSide;            // turno de las blancas
+
+/**
+ * @brief Returns the hash change of flipping a set of discs (both colors
+ * toggle on every flipped square), with one table lookup per board row.
+ */
+inline uint64_t getFlipHash(uint64_t flips)
+{
+    return zobristFlip[0][flips & 0xFF] ^
+           zobristFlip[1][(flips >> 8) & 0xFF] ^
+           zobristFlip[2][(flips >> 16) & 0xFF] ^
+           zobristFlip[3][(flips >> 24) & 0xFF] ^
+           zobristFlip[4][(flips >> 32) & 0xFF] ^
+           zobristFlip[5][(flips >> 40) & 0xFF] ^
+           zobristFlip[6][(flips >> 48) & 0xFF] ^
+           zobristFlip[7][flips >> 56];
+}
+
 struct GameModel
 {
     bool gameOver;
@@ -47,12 +69,14 @@ struct GameModel
     double playerTime[2];
     double turnTimer;
 
-    // Piece board[BOARD_SIZE][BOARD_SIZE]; //no la usamos, usamos bitboards ya que son ms eficientes y rpdios que una matriz
+    // Piece board[BOARD_SIZE][BOARD_SIZE]; //no la usamos, usamos bitboards ya que son más eficientes y rápdios que una matriz
     // 0 = empty, 1 = black, 2 = white
 
     uint64_t black = 0ULL; // bitboard para negras
     uint64_t white = 0ULL; // bitboard para blancas
 
+    uint64_t hash = 0ULL; // Zobrist de (black, white, currentPlayer)
+
     /*
     0  1  2  3  4  5  6  7
     8  9 10 11 12 13 14 15
@@ -63,16 +87,18 @@ struct GameModel
     48 49 50 51 52 53 54 55
     56 57 58 59 60 61 62 63
 
-    Cada nmero representa una posicin en el tablero.
-    Si el bit en esa posicin es 1, hay una ficha del color correspondiente.
+    Cada número representa una posición en el tablero.
+    Si el bit en esa posición es 1, hay una ficha del color correspondiente.
     Si es 0, no hay ficha.
     */
 
     Player humanPlayer;
 
 public:
-    // Colocar una pieza de un jugador en la posicin `pos`
+    // Colocar una pieza de un jugador en la posición `pos`
     void placePiece(Player p, int pos) {
+        removePiece(pos);
+        hash ^= zobristSquare[p][pos];
         if (p == PLAYER_BLACK) {
             black = setBit(black, pos);
             white = clearBit(white, pos);
@@ -89,6 +115,8 @@ public:
     }
     // Borra cualquier pieza (blanca o negra) en `pos`
     void removePiece(int pos) {
+        if (getBit(black, pos)) hash ^= zobristSquare[PLAYER_BLACK][pos];
+        if (getBit(white, pos)) hash ^= zobristSquare[PLAYER_WHITE][pos];
         black = clearBit(black, pos);
         white = clearBit(white, pos);
     }
@@ -114,7 +142,206 @@ private:
 
 };
 
-typedef std::vector<Square> Moves;
+/**
+ * @brief Returns the discs flipped by a move.
+ *
+ * @param me The bitboard of the side to move.
+ * @param opp The bitboard of the opponent.
+ * @param sq The (empty) square being played, 0-63.
+ * @return The bitboard of flipped discs; 0 if the move is illegal.
+ */
+uint64_t computeFlips(uint64_t me, uint64_t opp, int sq);
+
+/**
+ * @brief Generates the legal moves of a side as a bitboard.
+ *
+ * Branch-free, allocation-free parallel-prefix (Kogge-Stone) fill over the
+ * eight directions.
+ *
+ * @param me The bitboard of the side to move.
+ * @param opp The bitboard of the opponent.
+ * @return A bitboard with one bit set per legal move.
+ */
+uint64_t generateMoves(uint64_t me, uint64_t opp);
+
+/**
+ * @brief Generates the legal moves of many positions at once. The AVX2
+ * kernel processes four positions per instruction.
+ *
+ * @param me The bitboards of the sides to move.
+ * @param opp The bitboards of the opponents.
+ * @param moves Receives one legal move bitboard per position.
+ * @param count The number of positions.
+ */
+void generateMovesBatch(const uint64_t *me, const uint64_t *opp, uint64_t *moves, size_t count);
+
+/**
+ * @brief Move generator and flip kernels. The best one the CPU supports is
+ * selected at startup; REVERSI_MOVEGEN=scalar forces the portable one.
+ */
+enum MoveGenerator
+{
+    MOVEGEN_SCALAR,
+    MOVEGEN_AVX2,
+};
+
+/**
+ * @brief Switches the move generator kernels. Must not be called while a
+ * search is running.
+ *
+ * @param generator The move generator.
+ * @return Whether the CPU supports it; if not, nothing changes.
+ */
+bool setMoveGenerator(MoveGenerator generator);
+
+/**
+ * @brief Returns the move generator in use.
+ */
+MoveGenerator getMoveGenerator();
+
+/**
+ * @brief Returns a move generator's name ("scalar", "avx2").
+ */
+const char *getMoveGeneratorName(MoveGenerator generator);
+
+/**
+ * @brief Lightweight board state for search: copied by value, updated in
+ * place by makeMove/undoMove (XOR of the flip mask).
+ */
+struct Position
+{
+    uint64_t black;
+    uint64_t white;
+    Player currentPlayer;
+    uint64_t hash;
+
+public:
+    // Bitboard del jugador que mueve y del rival
+    uint64_t getPlayer() const {
+        return (currentPlayer == PLAYER_BLACK) ? black : white;
+    }
+    uint64_t getOpponent() const {
+        return (currentPlayer == PLAYER_BLACK) ? white : black;
+    }
+    // Movimientos legales del jugador que mueve
+    uint64_t getMoves() const {
+        return generateMoves(getPlayer(), getOpponent());
+    }
+    // Juega en `sq` y cambia de turno. Devuelve las fichas volteadas
+    // (necesarias para undoMove); 0 si la jugada es ilegal.
+    uint64_t makeMove(int sq) {
+        uint64_t flips = computeFlips(getPlayer(), getOpponent(), sq);
+        uint64_t square = 1ULL << sq;
+        hash ^= zobristSquare[currentPlayer][sq] ^ getFlipHash(flips) ^ zobristSide;
+        if (currentPlayer == PLAYER_BLACK) {
+            black ^= flips | square;
+            white ^= flips;
+        }
+        else {
+            white ^= flips | square;
+            black ^= flips;
+        }
+        currentPlayer = (currentPlayer == PLAYER_BLACK) ? PLAYER_WHITE : PLAYER_BLACK;
+        return flips;
+    }
+    // Deshace makeMove(sq) con las fichas que devolvió
+    void undoMove(int sq, uint64_t flips) {
+        uint64_t square = 1ULL << sq;
+        currentPlayer = (currentPlayer == PLAYER_BLACK) ? PLAYER_WHITE : PLAYER_BLACK;
+        hash ^= zobristSquare[currentPlayer][sq] ^ getFlipHash(flips) ^ zobristSide;
+        if (currentPlayer == PLAYER_BLACK) {
+            black ^= flips | square;
+            white ^= flips;
+        }
+        else {
+            white ^= flips | square;
+            black ^= flips;
+        }
+    }
+    // Pasa el turno sin jugar
+    void passMove() {
+        currentPlayer = (currentPlayer == PLAYER_BLACK) ? PLAYER_WHITE : PLAYER_BLACK;
+        hash ^= zobristSide;
+    }
+};
+
+// Cota de jugadas legales (el máximo alcanzable conocido es 33)
+#define MAX_MOVES 34
+
+/**
+ * @brief Fixed-capacity move list, kept on the stack: 1-byte squares
+ * (0-63) with scores for move ordering.
+ */
+struct MoveList
+{
+    uint8_t squares[MAX_MOVES];
+    int16_t scores[MAX_MOVES];
+    int count = 0;
+
+public:
+    void clear() {
+        count = 0;
+    }
+    int size() const {
+        return count;
+    }
+    bool empty() const {
+        return !count;
+    }
+    int operator[](int i) const {
+        return squares[i];
+    }
+    // Casilla `i` como Square (fila, columna, índice)
+    Square getSquare(int i) const {
+        Square square = {squares[i] / BOARD_SIZE, squares[i] % BOARD_SIZE, squares[i]};
+        return square;
+    }
+    bool contains(int sq) const {
+        for (int i = 0; i < count; i++)
+            if (squares[i] == sq)
+                return true;
+        return false;
+    }
+    void add(int sq, int score = 0) {
+        squares[count] = (uint8_t)sq;
+        scores[count++] = (int16_t)score;
+    }
+    // Inserta manteniendo el orden por puntaje, de mayor a menor (estable)
+    void addSorted(int sq, int score) {
+        int i = count++;
+        for (; i > 0 && scores[i - 1] < score; i--) {
+            squares[i] = squares[i - 1];
+            scores[i] = scores[i - 1];
+        }
+        squares[i] = (uint8_t)sq;
+        scores[i] = (int16_t)score;
+    }
+    // Lleva la jugada `i` al frente, conservando el orden del resto
+    void moveToFront(int i) {
+        uint8_t sq = squares[i];
+        int16_t score = scores[i];
+        for (; i > 0; i--) {
+            squares[i] = squares[i - 1];
+            scores[i] = scores[i - 1];
+        }
+        squares[0] = sq;
+        scores[0] = score;
+    }
+};
+
+/**
+ * @brief Clock used by the model to time the players' turns.
+ *
+ * @return The current time in seconds.
+ */
+typedef double (*ModelClock)();
+
+/**
+ * @brief Sets the clock used by the model (e.g. raylib's GetTime).
+ *
+ * @param clock The clock, or NULL to restore the default monotonic clock.
+ */
+void setModelClock(ModelClock clock);
 
 /**
  * @brief Initializes a game model.
@@ -189,7 +416,25 @@ bool isSquareValid(Square square);
  * @param model The game model.
  * @param validMoves A list that receives the valid moves.
  */
-void getValidMoves(GameModel &model, Moves &validMoves, uint64_t black_board, uint64_t white_board);
+void getValidMoves(GameModel &model, MoveList &validMoves, uint64_t black_board, uint64_t white_board);
+
+/**
+ * @brief Computes the Zobrist hash of a position from scratch.
+ *
+ * @param black The black bitboard.
+ * @param white The white bitboard.
+ * @param currentPlayer The side to move.
+ * @return The hash (equal to the incrementally maintained one).
+ */
+uint64_t computeHash(uint64_t black, uint64_t white, Player currentPlayer);
+
+/**
+ * @brief Returns the search position (boards and side to move) of a model.
+ *
+ * @param model The game model.
+ * @return The position.
+ */
+Position getPosition(GameModel &model);
 
 /**
  * @brief Plays a move.
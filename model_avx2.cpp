@@ -0,0 +1,156 @@
+/**
+ * @brief Implements the AVX2 move generation kernels
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#include "model_avx2.h"
+
+#ifdef REVERSI_X86_64
+
+#include <immintrin.h>
+
+#define INNER_COLUMNS 0x7E7E7E7E7E7E7E7EULL
+
+#define AVX2 REVERSI_TARGET("avx2")
+
+/*
+ * Single-position kernels: one 64-bit lane per direction pair (east/west,
+ * south/north, south-west/north-east, south-east/north-west), the positive
+ * shifts in one vector and the negative ones in another.
+ */
+
+// Desplazamientos por carril: 1 (horizontal), 8 (vertical), 7 y 9 (diagonales)
+AVX2 static inline __m256i getShifts()
+{
+    return _mm256_set_epi64x(9, 7, 8, 1);
+}
+
+// Rivales que pueden estar dentro de una cadena: sin columnas A/H salvo en vertical
+AVX2 static inline __m256i getInnerMask(uint64_t opp)
+{
+    return _mm256_and_si256(_mm256_set1_epi64x((long long)opp),
+                            _mm256_set_epi64x((long long)INNER_COLUMNS, (long long)INNER_COLUMNS,
+                                              -1LL, (long long)INNER_COLUMNS));
+}
+
+AVX2 static inline __m256i fillLeft(__m256i gen, __m256i o, __m256i shift, __m256i shift2)
+{
+    __m256i flip = _mm256_and_si256(o, _mm256_sllv_epi64(gen, shift));
+    flip = _mm256_or_si256(flip, _mm256_and_si256(o, _mm256_sllv_epi64(flip, shift)));
+    __m256i pre = _mm256_and_si256(o, _mm256_sllv_epi64(o, shift));
+    flip = _mm256_or_si256(flip, _mm256_and_si256(pre, _mm256_sllv_epi64(flip, shift2)));
+    flip = _mm256_or_si256(flip, _mm256_and_si256(pre, _mm256_sllv_epi64(flip, shift2)));
+    return flip;
+}
+
+AVX2 static inline __m256i fillRight(__m256i gen, __m256i o, __m256i shift, __m256i shift2)
+{
+    __m256i flip = _mm256_and_si256(o, _mm256_srlv_epi64(gen, shift));
+    flip = _mm256_or_si256(flip, _mm256_and_si256(o, _mm256_srlv_epi64(flip, shift)));
+    __m256i pre = _mm256_and_si256(o, _mm256_srlv_epi64(o, shift));
+    flip = _mm256_or_si256(flip, _mm256_and_si256(pre, _mm256_srlv_epi64(flip, shift2)));
+    flip = _mm256_or_si256(flip, _mm256_and_si256(pre, _mm256_srlv_epi64(flip, shift2)));
+    return flip;
+}
+
+AVX2 static inline uint64_t reduceOr(__m256i x)
+{
+    __m128i y = _mm_or_si128(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+    y = _mm_or_si128(y, _mm_unpackhi_epi64(y, y));
+    return (uint64_t)_mm_cvtsi128_si64(y);
+}
+
+AVX2 uint64_t generateMovesAvx2(uint64_t me, uint64_t opp)
+{
+    __m256i shift = getShifts();
+    __m256i shift2 = _mm256_add_epi64(shift, shift);
+    __m256i m = _mm256_set1_epi64x((long long)me);
+    __m256i o = getInnerMask(opp);
+
+    __m256i moves = _mm256_or_si256(_mm256_sllv_epi64(fillLeft(m, o, shift, shift2), shift),
+                                    _mm256_srlv_epi64(fillRight(m, o, shift, shift2), shift));
+
+    return reduceOr(moves) & ~(me | opp);
+}
+
+AVX2 uint64_t computeFlipsAvx2(uint64_t me, uint64_t opp, int sq)
+{
+    __m256i shift = getShifts();
+    __m256i shift2 = _mm256_add_epi64(shift, shift);
+    __m256i move = _mm256_set1_epi64x((long long)(1ULL << sq));
+    __m256i m = _mm256_set1_epi64x((long long)me);
+    __m256i o = getInnerMask(opp);
+    __m256i zero = _mm256_setzero_si256();
+
+    // Una cadena solo voltea si la casilla siguiente es propia
+    __m256i left = fillLeft(move, o, shift, shift2);
+    __m256i leftEnd = _mm256_and_si256(_mm256_sllv_epi64(left, shift), m);
+    left = _mm256_andnot_si256(_mm256_cmpeq_epi64(leftEnd, zero), left);
+
+    __m256i right = fillRight(move, o, shift, shift2);
+    __m256i rightEnd = _mm256_and_si256(_mm256_srlv_epi64(right, shift), m);
+    right = _mm256_andnot_si256(_mm256_cmpeq_epi64(rightEnd, zero), right);
+
+    return reduceOr(_mm256_or_si256(left, right));
+}
+
+/*
+ * Batch kernel: one position per lane, four positions per vector, with the
+ * eight directions unrolled as in the scalar generator.
+ */
+
+#define FILL_LEFT(gen, o, n, result)                                                  \
+    do                                                                                \
+    {                                                                                 \
+        __m256i flip_ = _mm256_and_si256(o, _mm256_slli_epi64(gen, n));               \
+        flip_ = _mm256_or_si256(flip_, _mm256_and_si256(o, _mm256_slli_epi64(flip_, n))); \
+        __m256i pre_ = _mm256_and_si256(o, _mm256_slli_epi64(o, n));                  \
+        flip_ = _mm256_or_si256(flip_, _mm256_and_si256(pre_, _mm256_slli_epi64(flip_, 2 * n))); \
+        flip_ = _mm256_or_si256(flip_, _mm256_and_si256(pre_, _mm256_slli_epi64(flip_, 2 * n))); \
+        result = _mm256_or_si256(result, _mm256_slli_epi64(flip_, n));                \
+    } while (0)
+
+#define FILL_RIGHT(gen, o, n, result)                                                 \
+    do                                                                                \
+    {                                                                                 \
+        __m256i flip_ = _mm256_and_si256(o, _mm256_srli_epi64(gen, n));               \
+        flip_ = _mm256_or_si256(flip_, _mm256_and_si256(o, _mm256_srli_epi64(flip_, n))); \
+        __m256i pre_ = _mm256_and_si256(o, _mm256_srli_epi64(o, n));                  \
+        flip_ = _mm256_or_si256(flip_, _mm256_and_si256(pre_, _mm256_srli_epi64(flip_, 2 * n))); \
+        flip_ = _mm256_or_si256(flip_, _mm256_and_si256(pre_, _mm256_srli_epi64(flip_, 2 * n))); \
+        result = _mm256_or_si256(result, _mm256_srli_epi64(flip_, n));                \
+    } while (0)
+
+AVX2 void generateMovesBatchAvx2(const uint64_t *me, const uint64_t *opp, uint64_t *moves,
+                                 size_t count)
+{
+    __m256i innerColumns = _mm256_set1_epi64x((long long)INNER_COLUMNS);
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256i m = _mm256_loadu_si256((const __m256i *)(me + i));
+        __m256i o = _mm256_loadu_si256((const __m256i *)(opp + i));
+        __m256i inner = _mm256_and_si256(o, innerColumns);
+        __m256i result = _mm256_setzero_si256();
+
+        FILL_LEFT(m, inner, 1, result);
+        FILL_RIGHT(m, inner, 1, result);
+        FILL_LEFT(m, o, 8, result);
+        FILL_RIGHT(m, o, 8, result);
+        FILL_LEFT(m, inner, 7, result);
+        FILL_RIGHT(m, inner, 7, result);
+        FILL_LEFT(m, inner, 9, result);
+        FILL_RIGHT(m, inner, 9, result);
+
+        result = _mm256_andnot_si256(_mm256_or_si256(m, o), result);
+        _mm256_storeu_si256((__m256i *)(moves + i), result);
+    }
+
+    for (; i < count; i++)
+        moves[i] = generateMovesAvx2(me[i], opp[i]);
+}
+
+#endif
@@ -0,0 +1,27 @@
+/**
+ * @brief Implements the AVX2 move generation kernels
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#ifndef MODEL_AVX2_H
+#define MODEL_AVX2_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "cpu.h"
+
+#ifdef REVERSI_X86_64
+/*
+ * Same contracts as generateMoves, computeFlips and generateMovesBatch
+ * (model.h). Only callable when getCpuFeatures().avx2 is set.
+ */
+uint64_t generateMovesAvx2(uint64_t me, uint64_t opp);
+uint64_t computeFlipsAvx2(uint64_t me, uint64_t opp, int sq);
+void generateMovesBatchAvx2(const uint64_t *me, const uint64_t *opp, uint64_t *moves,
+                            size_t count);
+#endif
+
+#endif
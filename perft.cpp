@@ -0,0 +1,200 @@
+/**
+ * @brief Perft: counts move-generator leaf nodes and checks them
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "bitops.h"
+#include "model.h"
+
+/*
+ * Known leaf counts from the start position. A pass counts as a ply and a
+ * finished game counts as one leaf, as in the usual Othello perft tables.
+ */
+static const uint64_t knownPerft[] = {
+    1ULL,
+    4ULL,
+    12ULL,
+    56ULL,
+    244ULL,
+    1396ULL,
+    8200ULL,
+    55092ULL,
+    390216ULL,
+    3005288ULL,
+    24571284ULL,
+    212258800ULL,
+};
+
+#define KNOWN_PERFT_DEPTH ((int)(sizeof(knownPerft) / sizeof(knownPerft[0])) - 1)
+
+static uint64_t perft(Position &position, int depth)
+{
+    if (depth == 0)
+        return 1;
+
+    uint64_t moves = position.getMoves();
+    if (!moves)
+    {
+        // Game over, or pass (counts as a ply)
+        if (!generateMoves(position.getOpponent(), position.getPlayer()))
+            return 1;
+
+        position.passMove();
+        uint64_t nodes = perft(position, depth - 1);
+        position.passMove();
+        return nodes;
+    }
+
+    // Bulk counting at the last ply
+    if (depth == 1)
+        return popCount(moves);
+
+    uint64_t nodes = 0;
+    while (moves)
+    {
+        int sq = popLowestSquare(moves);
+        uint64_t flips = position.makeMove(sq);
+        nodes += perft(position, depth - 1);
+        position.undoMove(sq, flips);
+    }
+
+    return nodes;
+}
+
+static void printUsage()
+{
+    printf("usage: perft [depth] [-d] [-t threads] [-p black white b|w]\n"
+           "  -d          divide: leaf count per root move\n"
+           "  -t threads  split root moves across threads\n"
+           "  -p          start from hex bitboards and side to move\n");
+}
+
+int main(int argc, char *argv[])
+{
+    int depth = 9;
+    bool divide = false;
+    int threads = 1;
+    bool customPosition = false;
+
+    Position position;
+    position.black = (1ULL << 28) | (1ULL << 35);
+    position.white = (1ULL << 27) | (1ULL << 36);
+    position.currentPlayer = PLAYER_BLACK;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-d"))
+            divide = true;
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-p") && i + 3 < argc)
+        {
+            position.black = strtoull(argv[++i], NULL, 16);
+            position.white = strtoull(argv[++i], NULL, 16);
+            position.currentPlayer = (argv[++i][0] == 'w') ? PLAYER_WHITE : PLAYER_BLACK;
+            customPosition = true;
+        }
+        else if (argv[i][0] >= '0' && argv[i][0] <= '9')
+            depth = atoi(argv[i]);
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (threads < 1)
+        threads = 1;
+    position.hash = computeHash(position.black, position.white, position.currentPlayer);
+
+    // Root moves (a root pass is a single move)
+    std::vector<int> rootMoves;
+    uint64_t moves = position.getMoves();
+    while (moves)
+        rootMoves.push_back(popLowestSquare(moves));
+    if (rootMoves.empty())
+        rootMoves.push_back(-1);
+
+    std::vector<uint64_t> rootNodes(rootMoves.size(), 0);
+    std::atomic<int> nextMove(0);
+
+    auto start = std::chrono::steady_clock::now();
+
+    if (depth == 0)
+        rootNodes.assign(1, 1);
+    else
+    {
+        auto worker = [&]() {
+            for (int i; (i = nextMove++) < (int)rootMoves.size();)
+            {
+                Position child = position;
+
+                if (rootMoves[i] < 0)
+                {
+                    if (!generateMoves(child.getOpponent(), child.getPlayer()))
+                    {
+                        rootNodes[i] = 1;
+                        continue;
+                    }
+                    child.passMove();
+                }
+                else
+                    child.makeMove(rootMoves[i]);
+
+                rootNodes[i] = perft(child, depth - 1);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (int i = 1; i < threads; i++)
+            workers.push_back(std::thread(worker));
+        worker();
+        for (auto &thread : workers)
+            thread.join();
+    }
+
+    double elapsed = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+    uint64_t nodes = 0;
+    for (size_t i = 0; i < rootNodes.size(); i++)
+    {
+        nodes += rootNodes[i];
+
+        if (divide && depth > 0)
+        {
+            if (rootMoves[i] < 0)
+                printf("pass: %llu\n", (unsigned long long)rootNodes[i]);
+            else
+                printf("%c%d: %llu\n",
+                       'a' + rootMoves[i] % BOARD_SIZE,
+                       rootMoves[i] / BOARD_SIZE + 1,
+                       (unsigned long long)rootNodes[i]);
+        }
+    }
+
+    printf("perft(%d) = %llu  time: %.3f s  nodes/s: %.0f\n",
+           depth, (unsigned long long)nodes, elapsed,
+           elapsed > 0 ? nodes / elapsed : 0.0);
+
+    if (!customPosition && depth <= KNOWN_PERFT_DEPTH)
+    {
+        bool ok = (nodes == knownPerft[depth]);
+        printf("%s (expected %llu)\n", ok ? "OK" : "MISMATCH",
+               (unsigned long long)knownPerft[depth]);
+        return ok ? 0 : 2;
+    }
+
+    return 0;
+}
@@ -0,0 +1,41 @@
+/**
+ * @brief Implements the board symmetry transforms
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#include "symmetry.h"
+
+CanonicalBoard canonical(uint64_t black, uint64_t white)
+{
+    CanonicalBoard best = {black, white, 0};
+
+    // The 8 forms, from the 4 flips and their transposes
+    uint64_t flippedBlack[4] = {black, mirrorHorizontal(black), 0, 0};
+    uint64_t flippedWhite[4] = {white, mirrorHorizontal(white), 0, 0};
+    flippedBlack[2] = flipVertical(black);
+    flippedWhite[2] = flipVertical(white);
+    flippedBlack[3] = flipVertical(flippedBlack[1]);
+    flippedWhite[3] = flipVertical(flippedWhite[1]);
+
+    for (int symmetry = 1; symmetry < SYMMETRY_COUNT; symmetry++)
+    {
+        uint64_t b = flippedBlack[symmetry & 3];
+        uint64_t w = flippedWhite[symmetry & 3];
+        if (symmetry & 4)
+        {
+            b = flipDiagonal(b);
+            w = flipDiagonal(w);
+        }
+
+        if (b < best.black || (b == best.black && w < best.white))
+        {
+            best.black = b;
+            best.white = w;
+            best.symmetry = symmetry;
+        }
+    }
+
+    return best;
+}
@@ -0,0 +1,166 @@
+/**
+ * @brief Implements the board symmetry transforms
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include <cstdint>
+
+/*
+ * The 8 board symmetries are numbered by the transforms they apply, in this
+ * order: bit 0 mirrors the columns, bit 1 flips the rows, bit 2 transposes
+ * (swaps rows and columns).
+ */
+#define SYMMETRY_COUNT 8
+
+/**
+ * @brief Mirrors the columns (a <-> h).
+ */
+inline uint64_t mirrorHorizontal(uint64_t x)
+{
+    x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+    x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+    x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return x;
+}
+
+/**
+ * @brief Flips the rows (1 <-> 8).
+ */
+inline uint64_t flipVertical(uint64_t x)
+{
+    x = ((x >> 8) & 0x00FF00FF00FF00FFULL) | ((x & 0x00FF00FF00FF00FFULL) << 8);
+    x = ((x >> 16) & 0x0000FFFF0000FFFFULL) | ((x & 0x0000FFFF0000FFFFULL) << 16);
+    x = (x >> 32) | (x << 32);
+    return x;
+}
+
+/**
+ * @brief Transposes along the a1-h8 diagonal, with delta swaps.
+ */
+inline uint64_t flipDiagonal(uint64_t x)
+{
+    uint64_t t;
+    t = 0x0F0F0F0F00000000ULL & (x ^ (x << 28));
+    x ^= t ^ (t >> 28);
+    t = 0x3333000033330000ULL & (x ^ (x << 14));
+    x ^= t ^ (t >> 14);
+    t = 0x5500550055005500ULL & (x ^ (x << 7));
+    x ^= t ^ (t >> 7);
+    return x;
+}
+
+/**
+ * @brief Transposes along the a8-h1 anti-diagonal, with delta swaps.
+ */
+inline uint64_t flipAntiDiagonal(uint64_t x)
+{
+    uint64_t t;
+    t = x ^ (x << 36);
+    x ^= 0xF0F0F0F00F0F0F0FULL & (t ^ (x >> 36));
+    t = 0xCCCC0000CCCC0000ULL & (x ^ (x << 18));
+    x ^= t ^ (t >> 18);
+    t = 0xAA00AA00AA00AA00ULL & (x ^ (x << 9));
+    x ^= t ^ (t >> 9);
+    return x;
+}
+
+/**
+ * @brief Rotates a quarter turn (a1 -> a8).
+ */
+inline uint64_t rotate90(uint64_t x)
+{
+    return flipVertical(flipDiagonal(x));
+}
+
+/**
+ * @brief Rotates a half turn (a1 -> h8).
+ */
+inline uint64_t rotate180(uint64_t x)
+{
+    return mirrorHorizontal(flipVertical(x));
+}
+
+/**
+ * @brief Rotates three quarter turns (a1 -> h1).
+ */
+inline uint64_t rotate270(uint64_t x)
+{
+    return flipDiagonal(flipVertical(x));
+}
+
+/**
+ * @brief Applies a symmetry to a bitboard.
+ *
+ * @param x The bitboard.
+ * @param symmetry The symmetry, 0 to SYMMETRY_COUNT - 1.
+ * @return The transformed bitboard.
+ */
+inline uint64_t transformBoard(uint64_t x, int symmetry)
+{
+    if (symmetry & 1)
+        x = mirrorHorizontal(x);
+    if (symmetry & 2)
+        x = flipVertical(x);
+    if (symmetry & 4)
+        x = flipDiagonal(x);
+    return x;
+}
+
+/**
+ * @brief Returns the symmetry that undoes another one.
+ *
+ * @param symmetry The symmetry.
+ * @return The inverse symmetry.
+ */
+inline int inverseSymmetry(int symmetry)
+{
+    // Transposing after the flips swaps which flip undoes which
+    if (symmetry & 4)
+        return 4 | ((symmetry & 1) << 1) | ((symmetry & 2) >> 1);
+    return symmetry;
+}
+
+/**
+ * @brief Applies a symmetry to a square.
+ *
+ * @param sq The square (0-63).
+ * @param symmetry The symmetry.
+ * @return The transformed square.
+ */
+inline int transformSquare(int sq, int symmetry)
+{
+    if (symmetry & 1)
+        sq ^= 7;
+    if (symmetry & 2)
+        sq ^= 56;
+    if (symmetry & 4)
+        sq = ((sq & 7) << 3) | (sq >> 3);
+    return sq;
+}
+
+/**
+ * @brief A position reduced over the board symmetries.
+ */
+struct CanonicalBoard
+{
+    uint64_t black;
+    uint64_t white;
+    int symmetry; // Maps the original position to this one
+};
+
+/**
+ * @brief Returns the smallest of the 8 symmetric forms of a position
+ * (ordered by black, then white), and the symmetry that produces it.
+ *
+ * @param black The black bitboard (or the side to move's).
+ * @param white The white bitboard (or the opponent's).
+ * @return The canonical position.
+ */
+CanonicalBoard canonical(uint64_t black, uint64_t white);
+
+#endif
@@ -0,0 +1,446 @@
+/**
+ * @brief Regression tests: symmetry, transposition table, book, training
+ * data and pondering invariants
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ai.h"
+#include "bitops.h"
+#include "book.h"
+#include "model.h"
+#include "symmetry.h"
+#include "trainingdata.h"
+#include "tt.h"
+
+#define TEST_POSITIONS 200
+
+// Temporary files, in the working directory (the build directory under ctest)
+#define TEST_BOOK_PATH "tests-book.tmp"
+#define TEST_DATA_PREFIX "tests-data"
+
+static int failures = 0;
+
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+
+static void check(bool ok, const char *text, const char *file, int line)
+{
+    if (ok)
+        return;
+
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, text);
+    failures++;
+}
+
+/**
+ * @brief Positions from random games, so they are reachable and varied.
+ */
+static std::vector<GameModel> getTestPositions(int count)
+{
+    std::mt19937_64 random(1);
+    std::vector<GameModel> positions;
+
+    while ((int)positions.size() < count)
+    {
+        GameModel model;
+        initModel(model);
+        model.humanPlayer = PLAYER_BLACK;
+        startModel(model);
+
+        int plies = 4 + (int)(random() % 50);
+        for (int ply = 0; ply < plies && !model.gameOver; ply++)
+        {
+            MoveList validMoves;
+            getValidMoves(model, validMoves, model.black, model.white);
+            playMove(model, validMoves.getSquare(random() % validMoves.size()));
+        }
+
+        if (!model.gameOver)
+            positions.push_back(model);
+    }
+
+    return positions;
+}
+
+/**
+ * @brief Whether some symmetry other than the identity maps the position to
+ * itself.
+ */
+static bool isSymmetric(uint64_t black, uint64_t white)
+{
+    for (int symmetry = 1; symmetry < SYMMETRY_COUNT; symmetry++)
+        if (transformBoard(black, symmetry) == black && transformBoard(white, symmetry) == white)
+            return true;
+
+    return false;
+}
+
+static GameModel transformModel(const GameModel &model, int symmetry)
+{
+    GameModel transformed = model;
+    transformed.black = transformBoard(model.black, symmetry);
+    transformed.white = transformBoard(model.white, symmetry);
+    transformed.hash = computeHash(transformed.black, transformed.white, model.currentPlayer);
+
+    return transformed;
+}
+
+static void testSymmetry()
+{
+    std::mt19937_64 random(1);
+
+    for (int symmetry = 0; symmetry < SYMMETRY_COUNT; symmetry++)
+    {
+        int inverse = inverseSymmetry(symmetry);
+        CHECK(inverseSymmetry(inverse) == symmetry);
+
+        for (int sq = 0; sq < 64; sq++)
+        {
+            int transformed = transformSquare(sq, symmetry);
+            CHECK(transformed >= 0 && transformed < 64);
+            CHECK(transformSquare(transformed, inverse) == sq);
+            CHECK(transformBoard(1ULL << sq, symmetry) == 1ULL << transformed);
+        }
+
+        for (int i = 0; i < 1000; i++)
+        {
+            uint64_t x = random();
+            CHECK(transformBoard(transformBoard(x, symmetry), inverse) == x);
+            CHECK(popCount(transformBoard(x, symmetry)) == popCount(x));
+        }
+    }
+
+    for (int i = 0; i < 1000; i++)
+    {
+        uint64_t x = random();
+        CHECK(rotate90(rotate90(x)) == rotate180(x));
+        CHECK(rotate90(rotate180(x)) == rotate270(x));
+        CHECK(rotate90(rotate270(x)) == x);
+        CHECK(flipAntiDiagonal(x) == rotate180(flipDiagonal(x)));
+    }
+
+    for (const GameModel &model : getTestPositions(TEST_POSITIONS))
+    {
+        uint64_t black = model.black;
+        uint64_t white = model.white;
+        CanonicalBoard key = canonical(black, white);
+
+        // The key is the symmetry's image of the position...
+        CHECK(transformBoard(black, key.symmetry) == key.black);
+        CHECK(transformBoard(white, key.symmetry) == key.white);
+
+        for (int symmetry = 0; symmetry < SYMMETRY_COUNT; symmetry++)
+        {
+            uint64_t b = transformBoard(black, symmetry);
+            uint64_t w = transformBoard(white, symmetry);
+
+            // ...and the same for all 8 forms
+            CanonicalBoard formKey = canonical(b, w);
+            CHECK(formKey.black == key.black && formKey.white == key.white);
+
+            // Move generation commutes with the symmetries
+            CHECK(generateMoves(b, w) == transformBoard(generateMoves(black, white), symmetry));
+        }
+    }
+}
+
+static void testTranspositionTable()
+{
+    std::mt19937_64 random(1);
+    TTData data;
+
+    // Before anything allocates the shared table, probes miss and stores
+    // are dropped
+    if (!ttGetSize())
+    {
+        ttStore(1, 5, 100, TT_BOUND_EXACT, 19);
+        CHECK(!ttProbe(1, data));
+        CHECK(!ttGetSize());
+    }
+
+    TTTable *table = ttCreate(1);
+    TTTable *other = ttCreate(1);
+    ttSetThreadTable(table);
+    ttClear();
+    ttNewSearch();
+
+    for (int i = 0; i < 1000; i++)
+    {
+        uint64_t hash = random();
+        int depth = (int)(random() % 60);
+        int score = (int)(random() % 12801) - 6400;
+        TTBound bound = (TTBound)(TT_BOUND_UPPER + random() % 3);
+        int move = (int)(random() % 64);
+
+        CHECK(!ttProbe(hash, data));
+        ttStore(hash, depth, score, bound, move);
+        CHECK(ttProbe(hash, data));
+        CHECK(data.depth == depth && data.score == score && data.bound == bound &&
+              data.move == move);
+    }
+
+    // A store without a move keeps the stored one
+    uint64_t hash = random();
+    ttStore(hash, 4, 100, TT_BOUND_LOWER, 19);
+    ttStore(hash, 5, 120, TT_BOUND_LOWER, TT_NO_MOVE);
+    CHECK(ttProbe(hash, data) && data.move == 19 && data.depth == 5);
+
+    // A much shallower bound does not replace a deeper result of this search
+    ttStore(hash, 2, -300, TT_BOUND_UPPER, 20);
+    CHECK(ttProbe(hash, data) && data.depth == 5 && data.score == 120);
+
+    // Tables are private to the threads that use them
+    ttSetThreadTable(other);
+    CHECK(!ttProbe(hash, data));
+    ttSetThreadTable(table);
+    ttClear();
+    CHECK(!ttProbe(hash, data));
+
+    ttSetThreadTable(nullptr);
+    ttDestroy(other);
+    ttDestroy(table);
+}
+
+/**
+ * @brief Score stored for a move of a test position.
+ */
+static int getTestScore(const GameModel &model, int sq)
+{
+    return (int)((model.hash >> (sq % 48)) & 0xFF) - 128;
+}
+
+static void testBook()
+{
+    std::vector<GameModel> positions;
+    for (const GameModel &model : getTestPositions(TEST_POSITIONS))
+        if (!isSymmetric(model.black, model.white))
+            positions.push_back(model);
+
+    // One entry per legal move, keyed as bookbuilder does
+    std::vector<BookEntry> entries;
+    for (GameModel &model : positions)
+    {
+        Position position = getPosition(model);
+        CanonicalBoard key = canonical(position.getPlayer(), position.getOpponent());
+
+        for (uint64_t moves = position.getMoves(); moves;)
+        {
+            int sq = popLowestSquare(moves);
+
+            BookEntry entry;
+            memset(&entry, 0, sizeof(entry));
+            entry.player = key.black;
+            entry.opponent = key.white;
+            entry.score = (int16_t)getTestScore(model, sq);
+            entry.move = (uint8_t)transformSquare(sq, key.symmetry);
+            entry.depth = 10;
+            entries.push_back(entry);
+        }
+    }
+
+    std::string error;
+    CHECK(saveBook(TEST_BOOK_PATH, entries, error));
+    CHECK(validateBook(TEST_BOOK_PATH, error));
+    CHECK(loadBook(TEST_BOOK_PATH, error));
+
+    // Every symmetric form finds the moves of the original position
+    for (GameModel &model : positions)
+    {
+        Position original = getPosition(model);
+
+        for (int symmetry = 0; symmetry < SYMMETRY_COUNT; symmetry++)
+        {
+            GameModel transformed = transformModel(model, symmetry);
+            Position position = getPosition(transformed);
+            int inverse = inverseSymmetry(symmetry);
+
+            std::vector<BookMove> moves;
+            CHECK(probeBook(position, moves));
+            CHECK((int)moves.size() == popCount(original.getMoves()));
+
+            for (size_t i = 0; i < moves.size(); i++)
+            {
+                int sq = transformSquare(moves[i].move, inverse);
+                CHECK(moves[i].score == getTestScore(model, sq));
+                CHECK(moves[i].depth == 10);
+                CHECK(i == 0 || moves[i - 1].score >= moves[i].score);
+            }
+        }
+    }
+
+    // The start position was never stored
+    GameModel start;
+    initModel(start);
+    startModel(start);
+    std::vector<BookMove> moves;
+    CHECK(!probeBook(getPosition(start), moves));
+
+    unloadBook();
+    remove(TEST_BOOK_PATH);
+}
+
+static bool isSameRecord(const TrainingRecord &a, const TrainingRecord &b)
+{
+    return !memcmp(&a, &b, sizeof(TrainingRecord));
+}
+
+static void removeTestShards()
+{
+    for (int shard = 0; shard < 8; shard++)
+        remove(getTrainingShardName(TEST_DATA_PREFIX, shard).c_str());
+}
+
+static void testTrainingData()
+{
+    std::mt19937_64 random(1);
+    std::vector<TrainingRecord> records;
+    for (const GameModel &model : getTestPositions(250))
+    {
+        TrainingRecord record;
+        memset(&record, 0, sizeof(record));
+        record.black = model.black;
+        record.white = model.white;
+        record.score = (int16_t)((int)(random() % 12801) - 6400);
+        record.result = (int8_t)((int)(random() % 129) - 64);
+        record.player = (uint8_t)model.currentPlayer;
+        record.depth = (uint8_t)(random() % 20);
+        records.push_back(record);
+    }
+
+    removeTestShards();
+
+    // 250 records, 100 per shard
+    std::string error;
+    TrainingWriter writer;
+    CHECK(openTrainingWriter(writer, TEST_DATA_PREFIX, 100, error));
+    for (const TrainingRecord &record : records)
+        CHECK(writeTrainingRecord(writer, record, error));
+    CHECK(closeTrainingWriter(writer, error));
+
+    const uint64_t shardCounts[] = {100, 100, 50};
+    size_t next = 0;
+    for (int shard = 0; shard < 3; shard++)
+    {
+        TrainingFile file;
+        CHECK(openTrainingFile(getTrainingShardName(TEST_DATA_PREFIX, shard).c_str(), file, error));
+        CHECK(file.count == shardCounts[shard]);
+        for (uint64_t i = 0; i < file.count && next < records.size(); i++)
+            CHECK(isSameRecord(file.records[i], records[next++]));
+        closeTrainingFile(file);
+    }
+    CHECK(next == records.size());
+
+    // Appending fills the last shard
+    CHECK(openTrainingWriter(writer, TEST_DATA_PREFIX, 100, error));
+    CHECK(writeTrainingRecord(writer, records[0], error));
+    CHECK(closeTrainingWriter(writer, error));
+
+    std::string lastShard = getTrainingShardName(TEST_DATA_PREFIX, 2);
+    TrainingFile file;
+    CHECK(openTrainingFile(lastShard.c_str(), file, error));
+    CHECK(file.count == 51 && isSameRecord(file.records[50], records[0]));
+    closeTrainingFile(file);
+
+    // A partial record is ignored by readers, and writers move past it
+    FILE *partial = fopen(lastShard.c_str(), "ab");
+    CHECK(partial && fwrite(&records[1], 1, 5, partial) == 5);
+    if (partial)
+        fclose(partial);
+
+    CHECK(openTrainingFile(lastShard.c_str(), file, error));
+    CHECK(file.count == 51);
+    closeTrainingFile(file);
+
+    CHECK(openTrainingWriter(writer, TEST_DATA_PREFIX, 100, error));
+    CHECK(writeTrainingRecord(writer, records[2], error));
+    CHECK(closeTrainingWriter(writer, error));
+    CHECK(openTrainingFile(getTrainingShardName(TEST_DATA_PREFIX, 3).c_str(), file, error));
+    CHECK(file.count == 1 && isSameRecord(file.records[0], records[2]));
+    closeTrainingFile(file);
+
+    // Symmetric forms keep the labels and are all different
+    TrainingRecord forms[SYMMETRY_COUNT];
+    for (const TrainingRecord &record : records)
+    {
+        int count = getTrainingSymmetries(record, forms);
+        CHECK(count >= 1 && count <= SYMMETRY_COUNT);
+        CHECK(count == SYMMETRY_COUNT || isSymmetric(record.black, record.white));
+
+        for (int i = 0; i < count; i++)
+        {
+            CHECK(forms[i].score == record.score && forms[i].result == record.result &&
+                  forms[i].player == record.player);
+            CanonicalBoard formKey = canonical(forms[i].black, forms[i].white);
+            CanonicalBoard key = canonical(record.black, record.white);
+            CHECK(formKey.black == key.black && formKey.white == key.white);
+
+            for (int j = 0; j < i; j++)
+                CHECK(forms[i].black != forms[j].black || forms[i].white != forms[j].white);
+        }
+    }
+
+    removeTestShards();
+}
+
+static void testPondering()
+{
+    // The human's first turn, before any search allocated the shared table
+    GameModel model;
+    initModel(model);
+    model.humanPlayer = PLAYER_BLACK;
+    startModel(model);
+
+    SearchLimits limits;
+    limits.maxTime = 0.1;
+    startPondering(model, limits);
+    CHECK(isPondering());
+
+    resetPondering();
+    CHECK(!isPondering() && !isSearchPending());
+}
+
+struct Test
+{
+    const char *name;
+    void (*run)();
+};
+
+static const Test tests[] = {
+    {"symmetry", testSymmetry},
+    {"tt", testTranspositionTable},
+    {"book", testBook},
+    {"trainingdata", testTrainingData},
+    {"ponder", testPondering},
+};
+
+int main(int argc, char *argv[])
+{
+    bool found = false;
+
+    for (const Test &test : tests)
+    {
+        if (argc > 1 && strcmp(argv[1], test.name))
+            continue;
+        found = true;
+
+        int before = failures;
+        test.run();
+        printf("%s: %s\n", test.name, (failures == before) ? "ok" : "FAILED");
+    }
+
+    if (!found)
+    {
+        printf("usage: tests [symmetry|tt|book|trainingdata|ponder]\n");
+        return 1;
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,527 @@
+/**
+ * @brief Tournament runner: engine-vs-engine matches with Elo statistics
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "ai.h"
+#include "log.h"
+#include "symmetry.h"
+#include "tt.h"
+#include "weightfile.h"
+
+/**
+ * @brief Settings of one engine: name=...,depth=...,time=...,nodes=...,
+ * weights=...,endgame=...
+ */
+struct EngineConfig
+{
+    std::string name;
+    int depth = 0;
+    double time = 0;
+    uint64_t nodes = 0;
+    int endgameEmpties = ENDGAME_DEFAULT_EMPTIES;
+    std::string weightsPath;
+
+    const int16_t *weights = nullptr;
+    MappedFile weightFile;
+};
+
+/**
+ * @brief Sequential probability ratio test between two Elo hypotheses.
+ */
+struct SprtConfig
+{
+    bool enabled = false;
+    double elo0 = 0;
+    double elo1 = 5;
+    double alpha = 0.05;
+    double beta = 0.05;
+};
+
+/**
+ * @brief Match results from the first engine's point of view.
+ */
+struct MatchStats
+{
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+    uint64_t nodes[2] = {0, 0};
+    double time[2] = {0, 0};
+    long long moves[2] = {0, 0};
+};
+
+struct Tournament
+{
+    EngineConfig engines[2];
+    std::vector<GameModel> openings;
+
+    int games = 100;
+    int threads = 1;
+    int plies = 8;
+    int balance = 4 * SCORE_DISC;
+    size_t hashSize = 16;
+    unsigned int seed = 1;
+    SprtConfig sprt;
+
+    std::atomic<int> nextGame{0};
+    std::atomic<bool> stop{false};
+    std::mutex mutex;
+    MatchStats stats;
+    int played = 0;
+    int sprtResult = 0; // 1: H1 accepted, -1: H0 accepted
+
+    std::chrono::steady_clock::time_point start;
+};
+
+static void printUsage()
+{
+    printf("usage: tournament [options]\n"
+           "  --engine spec    settings of the next engine (give two), comma-separated:\n"
+           "                   name=N,depth=D,time=S,nodes=N,weights=FILE,endgame=E\n"
+           "                   (default depth=4)\n"
+           "  --games N        number of games, played in color-swapped pairs (default 100)\n"
+           "  --threads N      parallel games (default: all cores)\n"
+           "  --plies N        random opening plies (default 8)\n"
+           "  --balance D      keep openings within D discs (default 4)\n"
+           "  --hash MB        transposition table per engine and thread (default 16)\n"
+           "  --seed N         opening seed (default 1)\n"
+           "  --sprt elo0 elo1 [alpha] [beta]\n"
+           "                   stop early once H0 (elo0) or H1 (elo1) is accepted\n");
+}
+
+static bool parseEngine(const char *spec, EngineConfig &engine, std::string &error)
+{
+    std::string text = spec;
+    size_t pos = 0;
+
+    while (pos <= text.size())
+    {
+        size_t end = text.find(',', pos);
+        if (end == std::string::npos)
+            end = text.size();
+        std::string item = text.substr(pos, end - pos);
+        pos = end + 1;
+        if (item.empty())
+            continue;
+
+        size_t equals = item.find('=');
+        if (equals == std::string::npos)
+        {
+            error = "expected key=value: " + item;
+            return false;
+        }
+        std::string key = item.substr(0, equals);
+        std::string value = item.substr(equals + 1);
+
+        if (key == "name")
+            engine.name = value;
+        else if (key == "depth")
+            engine.depth = atoi(value.c_str());
+        else if (key == "time")
+            engine.time = atof(value.c_str());
+        else if (key == "nodes")
+            engine.nodes = strtoull(value.c_str(), NULL, 10);
+        else if (key == "endgame")
+            engine.endgameEmpties = atoi(value.c_str());
+        else if (key == "weights")
+            engine.weightsPath = value;
+        else
+        {
+            error = "unknown engine setting: " + key;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static SearchLimits getLimits(const EngineConfig &engine, TTTable *table)
+{
+    SearchLimits limits;
+    limits.maxDepth = engine.depth;
+    limits.maxTime = engine.time;
+    limits.maxNodes = engine.nodes;
+    limits.endgameEmpties = engine.endgameEmpties;
+    limits.useBook = false;
+    limits.tt = table;
+    limits.evalWeights = engine.weights;
+    return limits;
+}
+
+/**
+ * @brief Random openings, kept if a shallow search finds them balanced and
+ * no symmetric form was already kept. Each one is played twice, once with
+ * each engine as black.
+ */
+static void buildOpenings(Tournament &tournament)
+{
+    int count = (tournament.games + 1) / 2;
+    std::mt19937_64 random(tournament.seed);
+    std::set<std::tuple<uint64_t, uint64_t, int>> seen;
+
+    TTTable *table = ttCreate(tournament.hashSize);
+    SearchLimits limits;
+    limits.maxDepth = 4;
+    limits.useBook = false;
+    limits.tt = table;
+
+    int attempts = 0;
+    while ((int)tournament.openings.size() < count)
+    {
+        GameModel model;
+        initModel(model);
+        model.humanPlayer = PLAYER_BLACK;
+        startModel(model);
+
+        for (int ply = 0; ply < tournament.plies && !model.gameOver; ply++)
+        {
+            MoveList validMoves;
+            getValidMoves(model, validMoves, model.black, model.white);
+            playMove(model, validMoves.getSquare(random() % validMoves.size()));
+        }
+        if (model.gameOver)
+            continue;
+
+        CanonicalBoard board = canonical(model.black, model.white);
+        bool unique = seen.insert(std::make_tuple(board.black, board.white,
+                                                  (int)model.currentPlayer))
+                          .second;
+
+        // Relax the filters when there are too few distinct or balanced
+        // openings (e.g. very few plies)
+        attempts++;
+        if (!unique && attempts <= 100 * count)
+            continue;
+        if (attempts <= 10 * count)
+        {
+            SearchResult result = searchBestMove(model, limits);
+            if (abs(result.score) > tournament.balance)
+                continue;
+        }
+
+        tournament.openings.push_back(model);
+    }
+
+    ttDestroy(table);
+}
+
+/**
+ * @brief Elo difference for a score (0 to 1).
+ */
+static double getElo(double score)
+{
+    if (score <= 0)
+        score = 1e-6;
+    else if (score >= 1)
+        score = 1 - 1e-6;
+
+    return -400 * log10(1 / score - 1);
+}
+
+/**
+ * @brief Score and per-game variance of the results.
+ */
+static void getMatchScore(const MatchStats &stats, double &score, double &variance)
+{
+    int n = stats.wins + stats.draws + stats.losses;
+    score = n ? (stats.wins + 0.5 * stats.draws) / n : 0.5;
+
+    variance = 0;
+    if (n)
+        variance = (stats.wins * (1 - score) * (1 - score) +
+                    stats.draws * (0.5 - score) * (0.5 - score) +
+                    stats.losses * score * score) /
+                   n;
+}
+
+/**
+ * @brief Log-likelihood ratio of H1 over H0 (normal approximation of the
+ * generalized SPRT), in Elo of the logistic model.
+ */
+static double getLLR(const MatchStats &stats, const SprtConfig &sprt)
+{
+    int n = stats.wins + stats.draws + stats.losses;
+    double score, variance;
+    getMatchScore(stats, score, variance);
+    if (!n || variance <= 0)
+        return 0;
+
+    double s0 = 1 / (1 + pow(10, -sprt.elo0 / 400));
+    double s1 = 1 / (1 + pow(10, -sprt.elo1 / 400));
+
+    return n * (s1 - s0) * (2 * score - s0 - s1) / (2 * variance);
+}
+
+// Progress lines: about 20 per tournament
+static int getProgressInterval(const Tournament &tournament)
+{
+    return std::max(1, tournament.games / 20);
+}
+
+static void printStats(Tournament &tournament)
+{
+    const MatchStats &stats = tournament.stats;
+    int n = stats.wins + stats.draws + stats.losses;
+    double score, variance;
+    getMatchScore(stats, score, variance);
+
+    // 95% confidence interval, through the slope of the Elo curve
+    double margin = n ? 1.96 * sqrt(variance / n) : 0;
+    double elo = getElo(score);
+    double slope = 400 / (log(10.0) * std::max(score * (1 - score), 1e-6));
+    double errorBar = std::min(slope * margin, 9999.0);
+
+    printf("games %d/%d  +%d =%d -%d  score %.3f  elo %+.1f +/- %.1f",
+           n, tournament.games, stats.wins, stats.draws, stats.losses,
+           score, elo, errorBar);
+
+    if (tournament.sprt.enabled)
+    {
+        const SprtConfig &sprt = tournament.sprt;
+        printf("  llr %+.2f (%.2f, %.2f)", getLLR(stats, sprt),
+               log(sprt.beta / (1 - sprt.alpha)), log((1 - sprt.beta) / sprt.alpha));
+    }
+
+    printf("\n");
+    fflush(stdout);
+}
+
+/**
+ * @brief Plays one game and returns the first engine's result: 1 win,
+ * 0 draw, -1 loss.
+ */
+static int playGame(Tournament &tournament, int game, TTTable *tables[2],
+                    MatchStats &gameStats)
+{
+    GameModel model = tournament.openings[game / 2];
+
+    // The first engine plays black in even games
+    Player firstColor = (game & 1) ? PLAYER_WHITE : PLAYER_BLACK;
+
+    for (int i = 0; i < 2; i++)
+    {
+        ttSetThreadTable(tables[i]);
+        ttClear();
+    }
+    ttSetThreadTable(nullptr);
+
+    while (!model.gameOver)
+    {
+        int engine = (model.currentPlayer == firstColor) ? 0 : 1;
+        SearchLimits limits = getLimits(tournament.engines[engine], tables[engine]);
+        limits.stop = &tournament.stop;
+
+        SearchResult result = searchBestMove(model, limits);
+        if (tournament.stop.load())
+            return 2;
+
+        gameStats.nodes[engine] += result.nodes;
+        gameStats.time[engine] += result.time;
+        gameStats.moves[engine]++;
+        playMove(model, result.bestMove);
+    }
+
+    Player secondColor = (firstColor == PLAYER_BLACK) ? PLAYER_WHITE : PLAYER_BLACK;
+    int diff = getScore(model, firstColor) - getScore(model, secondColor);
+
+    return (diff > 0) - (diff < 0);
+}
+
+static void runWorker(Tournament &tournament)
+{
+    TTTable *tables[2] = {ttCreate(tournament.hashSize), ttCreate(tournament.hashSize)};
+
+    while (!tournament.stop.load())
+    {
+        int game = tournament.nextGame++;
+        if (game >= tournament.games)
+            break;
+
+        MatchStats gameStats;
+        int result = playGame(tournament, game, tables, gameStats);
+        if (result == 2)
+            break;
+
+        std::lock_guard<std::mutex> lock(tournament.mutex);
+        MatchStats &stats = tournament.stats;
+        if (result > 0)
+            stats.wins++;
+        else if (result < 0)
+            stats.losses++;
+        else
+            stats.draws++;
+        for (int i = 0; i < 2; i++)
+        {
+            stats.nodes[i] += gameStats.nodes[i];
+            stats.time[i] += gameStats.time[i];
+            stats.moves[i] += gameStats.moves[i];
+        }
+        tournament.played++;
+
+        if (!(tournament.played % getProgressInterval(tournament)))
+            printStats(tournament);
+
+        if (tournament.sprt.enabled)
+        {
+            const SprtConfig &sprt = tournament.sprt;
+            double llr = getLLR(stats, sprt);
+            if (llr >= log((1 - sprt.beta) / sprt.alpha))
+                tournament.sprtResult = 1;
+            else if (llr <= log(sprt.beta / (1 - sprt.alpha)))
+                tournament.sprtResult = -1;
+            if (tournament.sprtResult)
+                tournament.stop.store(true);
+        }
+    }
+
+    ttDestroy(tables[0]);
+    ttDestroy(tables[1]);
+}
+
+int main(int argc, char *argv[])
+{
+    initLog();
+    loadDefaultWeightFile();
+
+    Tournament tournament;
+    tournament.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    int engineCount = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *option = argv[i];
+        bool hasValue = (i + 1 < argc);
+
+        if (!strcmp(option, "--engine") && hasValue && engineCount < 2)
+        {
+            std::string error;
+            if (!parseEngine(argv[++i], tournament.engines[engineCount], error))
+            {
+                fprintf(stderr, "tournament: %s\n", error.c_str());
+                return 1;
+            }
+            engineCount++;
+        }
+        else if (!strcmp(option, "--games") && hasValue)
+            tournament.games = atoi(argv[++i]);
+        else if (!strcmp(option, "--threads") && hasValue)
+            tournament.threads = atoi(argv[++i]);
+        else if (!strcmp(option, "--plies") && hasValue)
+            tournament.plies = atoi(argv[++i]);
+        else if (!strcmp(option, "--balance") && hasValue)
+            tournament.balance = (int)(atof(argv[++i]) * SCORE_DISC);
+        else if (!strcmp(option, "--hash") && hasValue)
+            tournament.hashSize = (size_t)atoi(argv[++i]);
+        else if (!strcmp(option, "--seed") && hasValue)
+            tournament.seed = (unsigned int)atoi(argv[++i]);
+        else if (!strcmp(option, "--sprt") && i + 2 < argc)
+        {
+            SprtConfig &sprt = tournament.sprt;
+            sprt.enabled = true;
+            sprt.elo0 = atof(argv[++i]);
+            sprt.elo1 = atof(argv[++i]);
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                sprt.alpha = atof(argv[++i]);
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                sprt.beta = atof(argv[++i]);
+        }
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (tournament.games < 1 || tournament.threads < 1 || tournament.hashSize < 1 ||
+        tournament.plies < 0 ||
+        (tournament.sprt.enabled &&
+         (tournament.sprt.alpha <= 0 || tournament.sprt.alpha >= 1 ||
+          tournament.sprt.beta <= 0 || tournament.sprt.beta >= 1)))
+    {
+        printUsage();
+        return 1;
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        EngineConfig &engine = tournament.engines[i];
+        if (!engine.depth && engine.time <= 0 && !engine.nodes)
+            engine.depth = 4;
+        if (engine.name.empty())
+            engine.name = "engine" + std::to_string(i + 1);
+
+        if (!engine.weightsPath.empty())
+        {
+            std::string error;
+            engine.weights = mapWeightFile(engine.weightsPath.c_str(), engine.weightFile,
+                                           error, true);
+            if (!engine.weights)
+            {
+                fprintf(stderr, "tournament: %s: %s\n", engine.weightsPath.c_str(),
+                        error.c_str());
+                return 1;
+            }
+        }
+    }
+
+    buildOpenings(tournament);
+
+    printf("%s vs %s: %d games, %d openings, %d threads\n",
+           tournament.engines[0].name.c_str(), tournament.engines[1].name.c_str(),
+           tournament.games, (int)tournament.openings.size(), tournament.threads);
+
+    tournament.start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < tournament.threads; i++)
+        workers.push_back(std::thread(runWorker, std::ref(tournament)));
+    for (auto &worker : workers)
+        worker.join();
+
+    double elapsed = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - tournament.start)
+                         .count();
+
+    if (tournament.played % getProgressInterval(tournament))
+        printStats(tournament);
+
+    const MatchStats &stats = tournament.stats;
+    for (int i = 0; i < 2; i++)
+    {
+        const EngineConfig &engine = tournament.engines[i];
+        printf("%s: %lld moves, %.1f ms/move, %.0f nodes/s\n", engine.name.c_str(),
+               stats.moves[i],
+               stats.moves[i] ? 1000 * stats.time[i] / stats.moves[i] : 0.0,
+               stats.time[i] > 0 ? stats.nodes[i] / stats.time[i] : 0.0);
+    }
+    printf("time: %.1f s, games/s: %.2f\n", elapsed,
+           elapsed > 0 ? tournament.played / elapsed : 0.0);
+
+    if (tournament.sprt.enabled)
+        printf("sprt: %s\n", (tournament.sprtResult > 0)   ? "H1 accepted"
+                             : (tournament.sprtResult < 0) ? "H0 accepted"
+                                                           : "inconclusive");
+
+    for (int i = 0; i < 2; i++)
+        unmapFile(tournament.engines[i].weightFile);
+
+    return 0;
+}
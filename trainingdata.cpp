@@ -0,0 +1,234 @@
+/**
+ * @brief Implements the binary training data files
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#include <cstring>
+
+#include "trainingdata.h"
+
+static bool checkHeader(const TrainingFileHeader &header, std::string &error)
+{
+    if (memcmp(header.magic, TRAINING_FILE_MAGIC, sizeof(header.magic)))
+        error = "not a training file";
+    else if (header.version != TRAINING_FILE_VERSION)
+        error = "unsupported version " + std::to_string(header.version);
+    else if (header.headerSize != sizeof(TrainingFileHeader) ||
+             header.recordSize != sizeof(TrainingRecord))
+        error = "bad header";
+    else
+        return true;
+
+    return false;
+}
+
+std::string getTrainingShardName(const std::string &prefix, int shard)
+{
+    char number[16];
+    snprintf(number, sizeof(number), "-%04d", shard);
+    return prefix + number + TRAINING_FILE_EXTENSION;
+}
+
+/**
+ * @brief Opens the first shard from writer.shard on that can take more
+ * records. Shards ending in a partial record are left alone, so appended
+ * records stay aligned.
+ */
+static bool openShard(TrainingWriter &writer, std::string &error)
+{
+    for (;; writer.shard++)
+    {
+        std::string path = getTrainingShardName(writer.prefix, writer.shard);
+        uint64_t size = 0;
+
+        FILE *file = fopen(path.c_str(), "rb");
+        if (file)
+        {
+            TrainingFileHeader header;
+            bool empty = (fread(&header, 1, sizeof(header), file) == 0);
+            if (!empty && (fseek(file, 0, SEEK_END) ||
+                           ftell(file) < (long)sizeof(header) ||
+                           !checkHeader(header, error)))
+            {
+                if (error.empty())
+                    error = "bad file size";
+                error = path + ": " + error;
+                fclose(file);
+                return false;
+            }
+            size = empty ? 0 : (uint64_t)ftell(file);
+            fclose(file);
+        }
+
+        uint64_t records = size ? (size - sizeof(TrainingFileHeader)) / sizeof(TrainingRecord) : 0;
+        bool partial = size && (size - sizeof(TrainingFileHeader)) % sizeof(TrainingRecord);
+        if (partial || (writer.shardRecords && records >= writer.shardRecords))
+            continue;
+
+        writer.file = fopen(path.c_str(), "ab");
+        if (!writer.file)
+        {
+            error = "cannot create " + path;
+            return false;
+        }
+        // Records are buffered by the writer
+        setvbuf(writer.file, NULL, _IONBF, 0);
+        writer.records = records;
+
+        if (!size)
+        {
+            TrainingFileHeader header;
+            memset(&header, 0, sizeof(header));
+            memcpy(header.magic, TRAINING_FILE_MAGIC, sizeof(header.magic));
+            header.version = TRAINING_FILE_VERSION;
+            header.headerSize = sizeof(TrainingFileHeader);
+            header.recordSize = sizeof(TrainingRecord);
+
+            if (fwrite(&header, sizeof(header), 1, writer.file) != 1)
+            {
+                error = "cannot write " + path;
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+/**
+ * @brief Writes the buffered records, moving on to the next shard when one
+ * is full.
+ */
+static bool flush(TrainingWriter &writer, std::string &error)
+{
+    size_t done = 0;
+
+    while (done < writer.buffer.size())
+    {
+        if (!writer.file && !openShard(writer, error))
+            return false;
+
+        size_t count = writer.buffer.size() - done;
+        if (writer.shardRecords && count > writer.shardRecords - writer.records)
+            count = (size_t)(writer.shardRecords - writer.records);
+
+        if (fwrite(&writer.buffer[done], sizeof(TrainingRecord), count, writer.file) != count)
+        {
+            error = "cannot write " + getTrainingShardName(writer.prefix, writer.shard);
+            return false;
+        }
+        done += count;
+        writer.records += count;
+
+        if (writer.shardRecords && writer.records >= writer.shardRecords)
+        {
+            bool ok = !fclose(writer.file);
+            writer.file = nullptr;
+            if (!ok)
+            {
+                error = "cannot write " + getTrainingShardName(writer.prefix, writer.shard);
+                return false;
+            }
+            writer.shard++;
+        }
+    }
+
+    writer.buffer.clear();
+    return true;
+}
+
+bool openTrainingWriter(TrainingWriter &writer, const std::string &prefix,
+                        uint64_t shardRecords, std::string &error)
+{
+    writer.prefix = prefix;
+    writer.shardRecords = shardRecords;
+    writer.shard = 0;
+    writer.records = 0;
+    writer.file = nullptr;
+    writer.buffer.clear();
+    writer.buffer.reserve(TRAINING_WRITE_BUFFER);
+
+    return openShard(writer, error);
+}
+
+bool writeTrainingRecord(TrainingWriter &writer, const TrainingRecord &record,
+                         std::string &error)
+{
+    writer.buffer.push_back(record);
+    if (writer.buffer.size() < TRAINING_WRITE_BUFFER)
+        return true;
+
+    return flush(writer, error);
+}
+
+bool closeTrainingWriter(TrainingWriter &writer, std::string &error)
+{
+    bool ok = flush(writer, error);
+
+    if (writer.file)
+    {
+        if (fclose(writer.file) && ok)
+        {
+            error = "cannot write " + getTrainingShardName(writer.prefix, writer.shard);
+            ok = false;
+        }
+        writer.file = nullptr;
+    }
+
+    return ok;
+}
+
+int getTrainingSymmetries(const TrainingRecord &record,
+                          TrainingRecord forms[SYMMETRY_COUNT])
+{
+    int count = 0;
+
+    for (int symmetry = 0; symmetry < SYMMETRY_COUNT; symmetry++)
+    {
+        TrainingRecord form = record;
+        form.black = transformBoard(record.black, symmetry);
+        form.white = transformBoard(record.white, symmetry);
+
+        // Symmetric positions give repeated forms
+        bool repeated = false;
+        for (int i = 0; i < count && !repeated; i++)
+            repeated = (forms[i].black == form.black && forms[i].white == form.white);
+        if (!repeated)
+            forms[count++] = form;
+    }
+
+    return count;
+}
+
+bool openTrainingFile(const char *path, TrainingFile &file, std::string &error)
+{
+    if (!mapFile(path, file.mappedFile))
+    {
+        error = std::string("cannot open ") + path;
+        return false;
+    }
+
+    const TrainingFileHeader *header = (const TrainingFileHeader *)file.mappedFile.data;
+    if (file.mappedFile.size < sizeof(TrainingFileHeader) || !checkHeader(*header, error))
+    {
+        if (error.empty())
+            error = "not a training file";
+        unmapFile(file.mappedFile);
+        return false;
+    }
+
+    // A partial record at the end (interrupted write) is ignored
+    file.records = (const TrainingRecord *)(file.mappedFile.data + sizeof(TrainingFileHeader));
+    file.count = (file.mappedFile.size - sizeof(TrainingFileHeader)) / sizeof(TrainingRecord);
+
+    return true;
+}
+
+void closeTrainingFile(TrainingFile &file)
+{
+    unmapFile(file.mappedFile);
+    file.records = nullptr;
+    file.count = 0;
+}
@@ -0,0 +1,152 @@
+/**
+ * @brief Implements the binary training data files
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#ifndef TRAININGDATA_H
+#define TRAININGDATA_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "mappedfile.h"
+#include "symmetry.h"
+
+#define TRAINING_FILE_MAGIC "RVSIDATA"
+#define TRAINING_FILE_VERSION 1
+#define TRAINING_FILE_EXTENSION ".rvd"
+
+// Records buffered by a writer before each write (1.5 MB)
+#define TRAINING_WRITE_BUFFER 65536
+
+/**
+ * @brief Training file header (64 bytes, little-endian). TrainingRecords
+ * follow it up to the end of the file: files are append-only, and a
+ * partial record left by an interrupted write is ignored.
+ */
+struct TrainingFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t recordSize;
+    uint8_t reserved[44];
+};
+
+/**
+ * @brief A labeled position (24 bytes). Scores are from the side to
+ * move's point of view.
+ */
+struct TrainingRecord
+{
+    uint64_t black;
+    uint64_t white;
+    int16_t score;  // Search score, SCORE_DISC per disc
+    int8_t result;  // Final disc difference, empties to the winner
+    uint8_t player; // Side to move
+    uint8_t depth;  // Search depth of the score
+    uint8_t reserved[3];
+};
+
+/**
+ * @brief Buffered, append-only writer of a sharded training data stream:
+ * prefix-0000.rvd, prefix-0001.rvd, ... Each writer must only be used by
+ * one thread; give each thread its own prefix.
+ */
+struct TrainingWriter
+{
+    std::string prefix;
+    uint64_t shardRecords = 0; // Records per shard (0: no limit)
+
+    int shard = 0;
+    uint64_t records = 0; // In the current shard
+    FILE *file = nullptr;
+    std::vector<TrainingRecord> buffer;
+};
+
+/**
+ * @brief A training file mapped read-only: the records are read in place,
+ * so files larger than memory can be streamed through.
+ */
+struct TrainingFile
+{
+    MappedFile mappedFile;
+    const TrainingRecord *records = nullptr;
+    uint64_t count = 0;
+};
+
+/**
+ * @brief Returns the name of a shard of a training data stream.
+ *
+ * @param prefix The stream prefix.
+ * @param shard The shard number.
+ * @return The file name.
+ */
+std::string getTrainingShardName(const std::string &prefix, int shard);
+
+/**
+ * @brief Opens a training data stream for appending, at the first shard
+ * that is not full.
+ *
+ * @param writer The writer.
+ * @param prefix The stream prefix (directory and base name).
+ * @param shardRecords Records per shard (0: no limit).
+ * @param error Receives an error message on failure.
+ * @return Whether the stream was opened.
+ */
+bool openTrainingWriter(TrainingWriter &writer, const std::string &prefix,
+                        uint64_t shardRecords, std::string &error);
+
+/**
+ * @brief Appends a record; it is written once the buffer is full.
+ *
+ * @param writer The writer.
+ * @param record The record.
+ * @param error Receives an error message on failure.
+ * @return Whether the record was buffered (and the buffer written).
+ */
+bool writeTrainingRecord(TrainingWriter &writer, const TrainingRecord &record,
+                         std::string &error);
+
+/**
+ * @brief Writes the buffered records and closes the stream.
+ *
+ * @param writer The writer.
+ * @param error Receives an error message on failure.
+ * @return Whether all records were written.
+ */
+bool closeTrainingWriter(TrainingWriter &writer, std::string &error);
+
+/**
+ * @brief Gets the symmetric forms of a record that differ from each other,
+ * for symmetry augmentation.
+ *
+ * @param record The record.
+ * @param forms Receives the forms, the record itself first.
+ * @return The number of forms.
+ */
+int getTrainingSymmetries(const TrainingRecord &record,
+                          TrainingRecord forms[SYMMETRY_COUNT]);
+
+/**
+ * @brief Maps a training file read-only.
+ *
+ * @param path The file path.
+ * @param file Receives the mapping.
+ * @param error Receives an error message on failure.
+ * @return Whether the file was opened.
+ */
+bool openTrainingFile(const char *path, TrainingFile &file, std::string &error);
+
+/**
+ * @brief Unmaps a training file.
+ *
+ * @param file The mapping.
+ */
+void closeTrainingFile(TrainingFile &file);
+
+#endif
@@ -0,0 +1,224 @@
+/**
+ * @brief Implements the transposition table
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#include <atomic>
+#include <memory>
+#include <new>
+
+#include "tt.h"
+
+#define TT_BUCKET_ENTRIES 4
+
+/*
+ * Entry data, packed in 64 bits:
+ *   bits  0-15  score (int16)
+ *   bits 16-23  depth
+ *   bits 24-25  bound
+ *   bits 26-32  move (0-63, TT_NO_MOVE)
+ *   bits 33-40  age
+ */
+struct TTEntry
+{
+    std::atomic<uint64_t> key; // hash ^ data
+    std::atomic<uint64_t> data;
+};
+
+// One bucket per cache line
+struct TTBucket
+{
+    TTEntry entries[TT_BUCKET_ENTRIES];
+};
+
+struct TTTable
+{
+    std::unique_ptr<char[]> storage;
+    TTBucket *buckets = nullptr;
+    uint64_t bucketMask = 0;
+    unsigned int currentAge = 0;
+};
+
+// The shared table, and the calling thread's own table if it has one
+static TTTable sharedTable;
+static thread_local TTTable *threadTable = nullptr;
+
+static inline TTTable &getTable()
+{
+    return threadTable ? *threadTable : sharedTable;
+}
+
+static inline uint64_t packData(int depth, int score, TTBound bound, int move, unsigned int age)
+{
+    return (uint64_t)(uint16_t)(int16_t)score |
+           ((uint64_t)(depth & 0xFF) << 16) |
+           ((uint64_t)bound << 24) |
+           ((uint64_t)(move & 0x7F) << 26) |
+           ((uint64_t)(age & 0xFF) << 33);
+}
+
+static inline int getDepth(uint64_t data)
+{
+    return (int)((data >> 16) & 0xFF);
+}
+
+static inline unsigned int getAge(uint64_t data)
+{
+    return (unsigned int)((data >> 33) & 0xFF);
+}
+
+static void resize(TTTable &table, size_t megabytes)
+{
+    size_t bytes = megabytes << 20;
+    size_t count = 1;
+
+    while (count * 2 * sizeof(TTBucket) <= bytes)
+        count *= 2;
+
+    table.storage.reset(new char[count * sizeof(TTBucket) + 64]);
+
+    // Align buckets to cache lines
+    uintptr_t address = ((uintptr_t)table.storage.get() + 63) & ~(uintptr_t)63;
+    table.buckets = (TTBucket *)address;
+    for (size_t i = 0; i < count; i++)
+        new (&table.buckets[i]) TTBucket();
+
+    table.bucketMask = count - 1;
+}
+
+static void clear(TTTable &table)
+{
+    for (uint64_t i = 0; table.buckets && i <= table.bucketMask; i++)
+        for (int j = 0; j < TT_BUCKET_ENTRIES; j++)
+        {
+            table.buckets[i].entries[j].key.store(0, std::memory_order_relaxed);
+            table.buckets[i].entries[j].data.store(0, std::memory_order_relaxed);
+        }
+
+    table.currentAge = 0;
+}
+
+void ttResize(size_t megabytes)
+{
+    resize(getTable(), megabytes);
+    ttClear();
+}
+
+TTTable *ttCreate(size_t megabytes)
+{
+    TTTable *table = new TTTable();
+    resize(*table, megabytes);
+    clear(*table);
+    return table;
+}
+
+void ttDestroy(TTTable *table)
+{
+    delete table;
+}
+
+void ttSetThreadTable(TTTable *table)
+{
+    threadTable = table;
+}
+
+TTTable *ttGetThreadTable()
+{
+    return threadTable;
+}
+
+size_t ttGetSize()
+{
+    TTTable &table = getTable();
+    return table.buckets ? (table.bucketMask + 1) * sizeof(TTBucket) : 0;
+}
+
+void ttClear()
+{
+    clear(getTable());
+}
+
+void ttNewSearch()
+{
+    TTTable &table = getTable();
+
+    if (!table.buckets)
+        ttResize(TT_DEFAULT_SIZE_MB);
+
+    table.currentAge = (table.currentAge + 1) & 0xFF;
+}
+
+bool ttProbe(uint64_t hash, TTData &data)
+{
+    TTTable &table = getTable();
+    if (!table.buckets)
+        return false;
+
+    TTBucket &bucket = table.buckets[hash & table.bucketMask];
+
+    for (int i = 0; i < TT_BUCKET_ENTRIES; i++)
+    {
+        uint64_t entryData = bucket.entries[i].data.load(std::memory_order_relaxed);
+        uint64_t entryKey = bucket.entries[i].key.load(std::memory_order_relaxed);
+
+        if ((entryKey ^ entryData) == hash && entryData)
+        {
+            data.score = (int16_t)(entryData & 0xFFFF);
+            data.depth = getDepth(entryData);
+            data.bound = (TTBound)((entryData >> 24) & 3);
+            data.move = (int)((entryData >> 26) & 0x7F);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ttStore(uint64_t hash, int depth, int score, TTBound bound, int move)
+{
+    TTTable &table = getTable();
+    if (!table.buckets)
+        return;
+
+    TTBucket &bucket = table.buckets[hash & table.bucketMask];
+    unsigned int currentAge = table.currentAge;
+    TTEntry *replace = &bucket.entries[0];
+    int replaceValue = 1 << 30;
+
+    for (int i = 0; i < TT_BUCKET_ENTRIES; i++)
+    {
+        TTEntry &entry = bucket.entries[i];
+        uint64_t entryData = entry.data.load(std::memory_order_relaxed);
+        uint64_t entryKey = entry.key.load(std::memory_order_relaxed);
+
+        if ((entryKey ^ entryData) == hash)
+        {
+            // Same position: keep a deeper result from this search
+            if (bound != TT_BOUND_EXACT &&
+                getAge(entryData) == currentAge &&
+                getDepth(entryData) > depth + 2)
+                return;
+
+            if (move == TT_NO_MOVE)
+                move = (int)((entryData >> 26) & 0x7F);
+
+            replace = &entry;
+            break;
+        }
+
+        // Prefer shallow entries from older searches
+        int age = (int)((currentAge - getAge(entryData)) & 0xFF);
+        int value = getDepth(entryData) - 8 * age;
+        if (value < replaceValue)
+        {
+            replaceValue = value;
+            replace = &entry;
+        }
+    }
+
+    uint64_t data = packData(depth, score, bound, move, currentAge);
+    replace->key.store(hash ^ data, std::memory_order_relaxed);
+    replace->data.store(data, std::memory_order_relaxed);
+}
@@ -0,0 +1,118 @@
+/**
+ * @brief Implements the transposition table
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#ifndef TT_H
+#define TT_H
+
+#include <cstddef>
+#include <cstdint>
+
+#define TT_DEFAULT_SIZE_MB 16
+
+// No move stored
+#define TT_NO_MOVE 64
+
+enum TTBound
+{
+    TT_BOUND_NONE,
+    TT_BOUND_UPPER,
+    TT_BOUND_LOWER,
+    TT_BOUND_EXACT,
+};
+
+/**
+ * @brief A decoded transposition table entry.
+ */
+struct TTData
+{
+    int score;
+    int depth;
+    TTBound bound;
+    int move;
+};
+
+/**
+ * @brief A transposition table. The functions below work on the calling
+ * thread's table: the shared one, unless ttSetThreadTable gave it its own.
+ */
+struct TTTable;
+
+/**
+ * @brief Allocates a separate table, e.g. one per engine in concurrent
+ * games.
+ *
+ * @param megabytes The size in MB (rounded down to a power of two buckets).
+ * @return The table.
+ */
+TTTable *ttCreate(size_t megabytes);
+
+/**
+ * @brief Frees a table from ttCreate. No thread may be using it.
+ */
+void ttDestroy(TTTable *table);
+
+/**
+ * @brief Selects the calling thread's table.
+ *
+ * @param table A table from ttCreate, or nullptr for the shared one.
+ */
+void ttSetThreadTable(TTTable *table);
+
+/**
+ * @brief Returns the calling thread's table; nullptr for the shared one.
+ */
+TTTable *ttGetThreadTable();
+
+/**
+ * @brief Allocates the table. Existing entries are lost.
+ *
+ * @param megabytes The size in MB (rounded down to a power of two buckets).
+ */
+void ttResize(size_t megabytes);
+
+/**
+ * @brief Returns the table size in bytes.
+ */
+size_t ttGetSize();
+
+/**
+ * @brief Clears every entry.
+ */
+void ttClear();
+
+/**
+ * @brief Starts a new search: entries from older searches age out first.
+ */
+void ttNewSearch();
+
+/**
+ * @brief Looks a position up.
+ *
+ * Safe to call concurrently with ttStore: each entry stores its key XOR-ed
+ * with its data, so a torn entry fails verification instead of returning
+ * mixed data.
+ *
+ * @param hash The position's Zobrist hash.
+ * @param data Receives the entry.
+ * @return Whether the position was found; always false before the table
+ * is allocated (by ttResize or the first ttNewSearch).
+ */
+bool ttProbe(uint64_t hash, TTData &data);
+
+/**
+ * @brief Stores a search result. Does nothing before the table is
+ * allocated.
+ *
+ * @param hash The position's Zobrist hash.
+ * @param depth The search depth.
+ * @param score The score.
+ * @param bound Whether the score is exact, a lower or an upper bound.
+ * @param move The best move (0-63) or TT_NO_MOVE.
+ */
+void ttStore(uint64_t hash, int depth, int score, TTBound bound, int move);
+
+#endif
@@ -0,0 +1,603 @@
+/**
+ * @brief Evaluation weight tuner: fits the weights to training data
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "bitops.h"
+#include "eval.h"
+#include "trainingdata.h"
+#include "weightfile.h"
+
+// Records per gradient step
+#define TUNER_DEFAULT_BATCH 4096
+
+enum TunerLoss
+{
+    LOSS_MSE,
+    LOSS_LOGISTIC,
+};
+
+struct TunerConfig
+{
+    int epochs = 10;
+    int threads = 1;
+    TunerLoss loss = LOSS_MSE;
+    double lambda = 0.5;   // Weight of the search score in the target (vs the result)
+    double rate = 2;       // Adam step size, in weight units
+    double scale = 8;      // Logistic scale, in discs
+    int batch = TUNER_DEFAULT_BATCH;
+    bool zero = false;
+    unsigned int seed = 1;
+};
+
+/**
+ * @brief The records of one game stage. Stages have separate weights and
+ * are trained one after the other, each mini-batch shared by all threads.
+ */
+struct StageData
+{
+    std::vector<TrainingFile> files;
+    uint64_t count = 0;
+};
+
+struct StageStats
+{
+    double loss = 0;
+    uint64_t count = 0;
+};
+
+/**
+ * @brief One mini-batch: records [start, start + batch size) of a file.
+ */
+typedef std::pair<int, uint64_t> Batch;
+
+/**
+ * @brief A thread's sparse gradient of its share of the current batch.
+ * Touched weights are listed by the thread that owns them (index modulo
+ * the number of threads), which reduces and updates them.
+ */
+struct GradientBuffer
+{
+    std::vector<float> gradient;
+    std::vector<uint8_t> touched;
+    std::vector<std::vector<int>> touchedByOwner;
+    StageStats stats[EVAL_STAGES];
+};
+
+/**
+ * @brief Reusable barrier for the training threads.
+ */
+struct Barrier
+{
+    std::mutex mutex;
+    std::condition_variable condition;
+    int threads = 1;
+    int waiting = 0;
+    uint64_t generation = 0;
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        uint64_t current = generation;
+
+        if (++waiting == threads)
+        {
+            waiting = 0;
+            generation++;
+            condition.notify_all();
+        }
+        else
+            condition.wait(lock, [&]() { return generation != current; });
+    }
+};
+
+/**
+ * @brief Weights and Adam moments, EVAL_STAGES * stage size of each.
+ */
+struct TunerState
+{
+    int stageSize;
+    std::vector<float> weights;
+    std::vector<float> m;
+    std::vector<float> v;
+    std::vector<uint32_t> steps; // Per stage
+
+    int instanceOffsets[EVAL_PATTERN_INSTANCES];
+};
+
+static void printUsage()
+{
+    printf("usage: tuner split <prefix> <file>...\n"
+           "  appends training records to <prefix>-sNN-0000.rvd, one stream per stage\n"
+           "       tuner train <prefix> <out.weights> [options]\n"
+           "  fits the weights to the stage streams, saving them after every epoch\n"
+           "  --epochs N      passes over the data (default 10)\n"
+           "  --threads N     threads sharing each batch (default: all cores)\n"
+           "  --loss L        mse or logistic (default mse)\n"
+           "  --lambda L      target = L * score + (1 - L) * result (default 0.5)\n"
+           "  --rate R        Adam step size (default 2)\n"
+           "  --scale D       logistic scale in discs (default 8)\n"
+           "  --batch N       records per step (default 4096)\n"
+           "  --zero          start from zero instead of the current weights\n"
+           "  --seed N        shuffle seed (default 1)\n");
+}
+
+static std::string getStagePrefix(const std::string &prefix, int stage)
+{
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), "-s%02d", stage);
+    return prefix + suffix;
+}
+
+/**
+ * @brief Streams the input files into one append-only stream per stage.
+ */
+static int splitData(const std::string &prefix, int count, char *paths[])
+{
+    TrainingWriter writers[EVAL_STAGES];
+    std::string error;
+
+    for (int stage = 0; stage < EVAL_STAGES; stage++)
+        if (!openTrainingWriter(writers[stage], getStagePrefix(prefix, stage), 0, error))
+        {
+            fprintf(stderr, "tuner: %s\n", error.c_str());
+            return 1;
+        }
+
+    uint64_t stageCounts[EVAL_STAGES] = {0};
+    bool ok = true;
+    for (int i = 0; i < count && ok; i++)
+    {
+        TrainingFile file;
+        if (!openTrainingFile(paths[i], file, error))
+        {
+            fprintf(stderr, "tuner: %s: %s\n", paths[i], error.c_str());
+            ok = false;
+            break;
+        }
+
+        for (uint64_t j = 0; j < file.count && ok; j++)
+        {
+            const TrainingRecord &record = file.records[j];
+            int stage = getEvalStage(popCount(record.black | record.white));
+            ok = writeTrainingRecord(writers[stage], record, error);
+            stageCounts[stage]++;
+        }
+        if (!ok)
+            fprintf(stderr, "tuner: %s\n", error.c_str());
+
+        closeTrainingFile(file);
+    }
+
+    for (int stage = 0; stage < EVAL_STAGES; stage++)
+        if (!closeTrainingWriter(writers[stage], error) && ok)
+        {
+            fprintf(stderr, "tuner: %s\n", error.c_str());
+            ok = false;
+        }
+
+    for (int stage = 0; stage < EVAL_STAGES; stage++)
+        printf("stage %2d: %llu records\n", stage, (unsigned long long)stageCounts[stage]);
+
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief Maps every shard of every stage stream.
+ */
+static bool openStages(const std::string &prefix, StageData stages[EVAL_STAGES])
+{
+    for (int stage = 0; stage < EVAL_STAGES; stage++)
+        for (int shard = 0;; shard++)
+        {
+            std::string path = getTrainingShardName(getStagePrefix(prefix, stage), shard);
+            FILE *file = fopen(path.c_str(), "rb");
+            if (!file)
+                break;
+            fclose(file);
+
+            TrainingFile trainingFile;
+            std::string error;
+            if (!openTrainingFile(path.c_str(), trainingFile, error))
+            {
+                fprintf(stderr, "tuner: %s: %s\n", path.c_str(), error.c_str());
+                return false;
+            }
+
+            stages[stage].files.push_back(trainingFile);
+            stages[stage].count += trainingFile.count;
+        }
+
+    return true;
+}
+
+static inline double getSigmoid(double x)
+{
+    return 1 / (1 + exp(-x));
+}
+
+/**
+ * @brief Shuffled batches of a stage, so the weights do not drift towards
+ * the games written last.
+ */
+static std::vector<Batch> getBatches(const TunerConfig &config, const StageData &data,
+                                     int stage, int epoch)
+{
+    std::vector<Batch> batches;
+    for (size_t i = 0; i < data.files.size(); i++)
+        for (uint64_t start = 0; start < data.files[i].count; start += config.batch)
+            batches.push_back(std::make_pair((int)i, start));
+
+    std::mt19937_64 random(config.seed + (uint64_t)epoch * EVAL_STAGES + stage);
+    std::shuffle(batches.begin(), batches.end(), random);
+
+    return batches;
+}
+
+/**
+ * @brief Adds the loss gradient of records [begin, end) of a file to the
+ * thread's buffer.
+ */
+static void accumulateGradient(const TunerConfig &config, const TunerState &state, int stage,
+                               const TrainingFile &file, uint64_t begin, uint64_t end,
+                               GradientBuffer &buffer)
+{
+    int stageSize = state.stageSize;
+    int mobilityOffset = getMobilityOffset();
+    int threads = (int)buffer.touchedByOwner.size();
+    const float *weights = &state.weights[(size_t)stage * stageSize];
+    double scale = config.scale * SCORE_DISC;
+    StageStats &stats = buffer.stats[stage];
+
+    auto add = [&](int index, double value) {
+        if (!buffer.touched[index])
+        {
+            buffer.touched[index] = 1;
+            buffer.touchedByOwner[index % threads].push_back(index);
+        }
+        buffer.gradient[index] += (float)value;
+    };
+
+    for (uint64_t j = begin; j < end; j++)
+    {
+        const TrainingRecord &record = file.records[j];
+
+        int indices[EVAL_PATTERN_INSTANCES];
+        computePatternIndices(record.black, record.white, indices);
+
+        bool black = (record.player == PLAYER_BLACK);
+        uint64_t me = black ? record.black : record.white;
+        uint64_t opp = black ? record.white : record.black;
+        int mobility = popCount(generateMoves(me, opp)) - popCount(generateMoves(opp, me));
+        int potentialMobility = getPotentialMobility(me, opp);
+
+        // Same as evaluate, without the clamp
+        double patternScore = 0;
+        for (int i = 0; i < EVAL_PATTERN_INSTANCES; i++)
+            patternScore += weights[state.instanceOffsets[i] + indices[i]];
+        double sign = black ? 1 : -1;
+        double prediction = sign * patternScore +
+                            weights[mobilityOffset] * mobility +
+                            weights[mobilityOffset + 1] * potentialMobility;
+
+        double error;
+        if (config.loss == LOSS_MSE)
+        {
+            double target = config.lambda * record.score +
+                            (1 - config.lambda) * record.result * SCORE_DISC;
+            error = prediction - target;
+            stats.loss += error * error;
+        }
+        else
+        {
+            double outcome = (record.result > 0) ? 1 : (record.result < 0) ? 0 : 0.5;
+            double target = config.lambda * getSigmoid(record.score / scale) +
+                            (1 - config.lambda) * outcome;
+            double p = getSigmoid(prediction / scale);
+            stats.loss -= target * log(std::max(p, 1e-12)) +
+                          (1 - target) * log(std::max(1 - p, 1e-12));
+            error = (p - target) / scale;
+        }
+        stats.count++;
+
+        for (int i = 0; i < EVAL_PATTERN_INSTANCES; i++)
+            add(state.instanceOffsets[i] + indices[i], error * sign);
+        add(mobilityOffset, error * mobility);
+        add(mobilityOffset + 1, error * potentialMobility);
+    }
+}
+
+/**
+ * @brief Sums the threads' gradients of the weights that `owner` owns and
+ * takes a lazy Adam step on them, clearing the buffers behind it.
+ */
+static void applyGradient(const TunerConfig &config, TunerState &state, int stage,
+                          std::vector<GradientBuffer> &buffers, int owner,
+                          uint32_t step, double count)
+{
+    const double beta1 = 0.9;
+    const double beta2 = 0.999;
+    const double epsilon = 1e-8;
+
+    int stageSize = state.stageSize;
+    float *weights = &state.weights[(size_t)stage * stageSize];
+    float *m = &state.m[(size_t)stage * stageSize];
+    float *v = &state.v[(size_t)stage * stageSize];
+    double correction1 = 1 - pow(beta1, step);
+    double correction2 = 1 - pow(beta2, step);
+    int threads = (int)buffers.size();
+
+    for (int k = 0; k < threads; k++)
+        for (int index : buffers[k].touchedByOwner[owner])
+        {
+            // Already reduced from an earlier buffer
+            if (!buffers[k].touched[index])
+                continue;
+
+            // In thread order, so a run does not depend on the schedule
+            float sum = 0;
+            for (int j = k; j < threads; j++)
+                if (buffers[j].touched[index])
+                {
+                    sum += buffers[j].gradient[index];
+                    buffers[j].gradient[index] = 0;
+                    buffers[j].touched[index] = 0;
+                }
+
+            double g = sum / count;
+            m[index] = (float)(beta1 * m[index] + (1 - beta1) * g);
+            v[index] = (float)(beta2 * v[index] + (1 - beta2) * g * g);
+            weights[index] -= (float)(config.rate * (m[index] / correction1) /
+                                      (sqrt(v[index] / correction2) + epsilon));
+        }
+}
+
+/**
+ * @brief One epoch of one training thread: for every batch of every stage,
+ * the gradient of this thread's slice of the batch, then the update of the
+ * weights it owns once all slices are in.
+ */
+static void trainThread(const TunerConfig &config, TunerState &state,
+                        const StageData stages[EVAL_STAGES],
+                        const std::vector<Batch> batches[EVAL_STAGES],
+                        std::vector<GradientBuffer> &buffers, Barrier &barrier,
+                        int threadIndex)
+{
+    GradientBuffer &buffer = buffers[threadIndex];
+    int threads = (int)buffers.size();
+
+    for (int stage = 0; stage < EVAL_STAGES; stage++)
+    {
+        uint32_t firstStep = state.steps[stage];
+
+        for (size_t i = 0; i < batches[stage].size(); i++)
+        {
+            const Batch &batch = batches[stage][i];
+            const TrainingFile &file = stages[stage].files[batch.first];
+            uint64_t end = std::min(file.count, batch.second + config.batch);
+            uint64_t count = end - batch.second;
+
+            accumulateGradient(config, state, stage, file,
+                               batch.second + count * threadIndex / threads,
+                               batch.second + count * (threadIndex + 1) / threads, buffer);
+            barrier.wait();
+
+            applyGradient(config, state, stage, buffers, threadIndex,
+                          firstStep + (uint32_t)i + 1, (double)count);
+            barrier.wait();
+
+            for (std::vector<int> &touched : buffer.touchedByOwner)
+                touched.clear();
+        }
+
+        // The other threads only read the steps of later stages
+        if (!threadIndex)
+            state.steps[stage] = firstStep + (uint32_t)batches[stage].size();
+    }
+}
+
+static bool saveWeights(const TunerState &state, const char *path)
+{
+    std::vector<int16_t> weights(state.weights.size());
+    for (size_t i = 0; i < weights.size(); i++)
+    {
+        float w = roundf(state.weights[i]);
+        weights[i] = (int16_t)std::max(-32767.0f, std::min(32767.0f, w));
+    }
+
+    std::string error;
+    if (!saveWeightFile(path, &weights[0], error))
+    {
+        fprintf(stderr, "tuner: %s\n", error.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+static int trainWeights(const std::string &prefix, const char *outputPath,
+                        const TunerConfig &config)
+{
+    StageData stages[EVAL_STAGES];
+    if (!openStages(prefix, stages))
+        return 1;
+
+    uint64_t total = 0;
+    for (int stage = 0; stage < EVAL_STAGES; stage++)
+        total += stages[stage].count;
+    if (!total)
+    {
+        fprintf(stderr, "tuner: no records in %s-sNN-*%s\n", prefix.c_str(),
+                TRAINING_FILE_EXTENSION);
+        return 1;
+    }
+
+    TunerState state;
+    state.stageSize = getEvalStageSize();
+    size_t size = (size_t)EVAL_STAGES * state.stageSize;
+    state.weights.assign(size, 0);
+    state.m.assign(size, 0);
+    state.v.assign(size, 0);
+    state.steps.assign(EVAL_STAGES, 0);
+    if (!config.zero)
+    {
+        const int16_t *weights = getEvalWeights();
+        for (size_t i = 0; i < size; i++)
+            state.weights[i] = weights[i];
+    }
+
+    const EvalPattern *patterns = getEvalPatterns();
+    for (int i = 0; i < EVAL_PATTERN_INSTANCES; i++)
+        state.instanceOffsets[i] = getPatternOffset(patterns[i].type);
+
+    int stageCount = 0;
+    for (int stage = 0; stage < EVAL_STAGES; stage++)
+        stageCount += (stages[stage].count > 0);
+
+    int threads = config.threads;
+    printf("%llu records, %d stages, %d threads\n", (unsigned long long)total,
+           stageCount, threads);
+
+    std::vector<GradientBuffer> buffers(threads);
+    for (GradientBuffer &buffer : buffers)
+    {
+        buffer.gradient.assign(state.stageSize, 0);
+        buffer.touched.assign(state.stageSize, 0);
+        buffer.touchedByOwner.resize(threads);
+    }
+    Barrier barrier;
+    barrier.threads = threads;
+
+    for (int epoch = 0; epoch < config.epochs; epoch++)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<Batch> batches[EVAL_STAGES];
+        for (int stage = 0; stage < EVAL_STAGES; stage++)
+            batches[stage] = getBatches(config, stages[stage], stage, epoch);
+
+        for (GradientBuffer &buffer : buffers)
+            for (StageStats &stats : buffer.stats)
+                stats = StageStats();
+
+        std::vector<std::thread> workers;
+        for (int i = 0; i < threads; i++)
+            workers.push_back(std::thread(trainThread, std::cref(config), std::ref(state),
+                                          stages, batches, std::ref(buffers),
+                                          std::ref(barrier), i));
+        for (auto &worker : workers)
+            worker.join();
+
+        double elapsed = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+
+        StageStats all;
+        for (const GradientBuffer &buffer : buffers)
+            for (const StageStats &stats : buffer.stats)
+            {
+                all.loss += stats.loss;
+                all.count += stats.count;
+            }
+
+        if (config.loss == LOSS_MSE)
+            printf("epoch %d: rms error %.3f discs", epoch + 1,
+                   sqrt(all.loss / all.count) / SCORE_DISC);
+        else
+            printf("epoch %d: cross-entropy %.5f", epoch + 1, all.loss / all.count);
+        printf("  %.1f s  %.0f records/s\n", elapsed, elapsed > 0 ? all.count / elapsed : 0.0);
+        fflush(stdout);
+
+        if (!saveWeights(state, outputPath))
+            return 1;
+    }
+
+    for (int stage = 0; stage < EVAL_STAGES; stage++)
+        for (TrainingFile &file : stages[stage].files)
+            closeTrainingFile(file);
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc >= 4 && !strcmp(argv[1], "split"))
+        return splitData(argv[2], argc - 3, argv + 3);
+
+    if (argc < 4 || strcmp(argv[1], "train"))
+    {
+        printUsage();
+        return 1;
+    }
+
+    loadDefaultWeightFile();
+
+    TunerConfig config;
+    config.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 4; i < argc; i++)
+    {
+        const char *option = argv[i];
+        bool hasValue = (i + 1 < argc);
+
+        if (!strcmp(option, "--epochs") && hasValue)
+            config.epochs = atoi(argv[++i]);
+        else if (!strcmp(option, "--threads") && hasValue)
+            config.threads = atoi(argv[++i]);
+        else if (!strcmp(option, "--loss") && hasValue)
+        {
+            const char *loss = argv[++i];
+            if (!strcmp(loss, "mse"))
+                config.loss = LOSS_MSE;
+            else if (!strcmp(loss, "logistic"))
+                config.loss = LOSS_LOGISTIC;
+            else
+            {
+                printUsage();
+                return 1;
+            }
+        }
+        else if (!strcmp(option, "--lambda") && hasValue)
+            config.lambda = atof(argv[++i]);
+        else if (!strcmp(option, "--rate") && hasValue)
+            config.rate = atof(argv[++i]);
+        else if (!strcmp(option, "--scale") && hasValue)
+            config.scale = atof(argv[++i]);
+        else if (!strcmp(option, "--batch") && hasValue)
+            config.batch = atoi(argv[++i]);
+        else if (!strcmp(option, "--zero"))
+            config.zero = true;
+        else if (!strcmp(option, "--seed") && hasValue)
+            config.seed = (unsigned int)atoi(argv[++i]);
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (config.epochs < 1 || config.threads < 1 || config.batch < 1 ||
+        config.rate <= 0 || config.scale <= 0 || config.lambda < 0 || config.lambda > 1)
+    {
+        printUsage();
+        return 1;
+    }
+
+    return trainWeights(argv[2], argv[3], config);
+}
@@ -5,10 +5,12 @@
  * @copyright Copyright (c) 2023-2024
  */
 
+#include <cstdio>
 #include <string>
 
 #include "raylib.h"
 
+#include "ai.h"
 #include "controller.h"
 #include "model.h"
 
@@ -57,6 +59,13 @@
 #define INFO_PLAYWHITE_BUTTON_X INFO_CENTERED_X
 #define INFO_PLAYWHITE_BUTTON_Y (WINDOW_HEIGHT * 7 / 8)
 
+#define STATS_X (BOARD_X + 10)
+#define STATS_Y (BOARD_Y + 10)
+#define STATS_WIDTH 340
+#define STATS_PADDING 10
+#define STATS_FONT_SIZE 20
+#define STATS_LINE_HEIGHT 24
+
 void initView()
 {
     InitWindow(WINDOW_WIDTH, WINDOW_HEIGHT, GAME_NAME);
@@ -151,6 +160,45 @@ static void drawButton(Vector2 position,
                      label.c_str());
 }
 
+/**
+ * @brief Draws the search statistics over the board.
+ *
+ * @param stats The statistics.
+ */
+static void drawSearchStats(const SearchStats &stats)
+{
+    char lines[8][64];
+    int lineCount = 0;
+
+    snprintf(lines[lineCount++], sizeof(lines[0]), "depth %d%s%s", stats.depth,
+             stats.book ? " (book)" : "", stats.endgame ? " (endgame)" : "");
+    snprintf(lines[lineCount++], sizeof(lines[0]), "nodes %llu",
+             (unsigned long long)stats.nodes);
+    snprintf(lines[lineCount++], sizeof(lines[0]), "nodes/s %.0f", stats.nodesPerSecond);
+    snprintf(lines[lineCount++], sizeof(lines[0]), "time %.2f / %.2f s",
+             stats.time, stats.timeBudget);
+    snprintf(lines[lineCount++], sizeof(lines[0]), "branching factor %.2f",
+             stats.branchingFactor);
+    snprintf(lines[lineCount++], sizeof(lines[0]), "TT hit rate %.1f%%",
+             stats.ttProbes ? 100.0 * stats.ttHits / stats.ttProbes : 0.0);
+    snprintf(lines[lineCount++], sizeof(lines[0]), "first move cutoffs %.1f%%",
+             stats.betaCutoffs ? 100.0 * stats.cutoffsAt[0] / stats.betaCutoffs : 0.0);
+    snprintf(lines[lineCount++], sizeof(lines[0]), "threads %d", stats.threads);
+
+    DrawRectangle(STATS_X,
+                  STATS_Y,
+                  STATS_WIDTH,
+                  2 * STATS_PADDING + lineCount * STATS_LINE_HEIGHT,
+                  Fade(BLACK, 0.7F));
+
+    for (int i = 0; i < lineCount; i++)
+        DrawText(lines[i],
+                 STATS_X + STATS_PADDING,
+                 STATS_Y + STATS_PADDING + i * STATS_LINE_HEIGHT,
+                 STATS_FONT_SIZE,
+                 RAYWHITE);
+}
+
 /**
  * @brief Indicates whether the mouse pointer is over a button.
  *
@@ -166,7 +214,7 @@ static bool isMousePointerOverButton(Vector2 position)
             (mousePosition.y < (position.y + INFO_BUTTON_HEIGHT / 2)));
 }
 
-void drawView(GameModel &model)
+void drawView(GameModel &model, const SearchStats *stats)
 {
     BeginDrawing();
 
@@ -242,6 +290,9 @@ void drawView(GameModel &model)
                    WHITE);
     }
 
+    if (stats)
+        drawSearchStats(*stats);
+
     EndDrawing();
 }
 
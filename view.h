@@ -10,6 +10,8 @@
 
 #include "model.h"
 
+struct SearchStats;
+
 /**
  * @brief Initializes a game view.
  */
@@ -24,8 +26,9 @@ void freeView();
  * @brief Draws the game view.
  *
  * @param model The game model.
+ * @param stats Search statistics to show over the board, or nullptr.
  */
-void drawView(GameModel &model);
+void drawView(GameModel &model, const SearchStats *stats = nullptr);
 
 /**
  * @brief Returns the square over the mouse pointer.
@@ -0,0 +1,197 @@
+/**
+ * @brief Implements the binary evaluation weight file
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "eval.h"
+#include "log.h"
+#include "mappedfile.h"
+#include "weightfile.h"
+
+static MappedFile loadedFile;
+
+/**
+ * @brief Fingerprint of the pattern layout: files written for other
+ * patterns or table sizes are rejected.
+ */
+static uint32_t getLayoutHash()
+{
+    uint32_t hash = 0x811C9DC5U;
+    const EvalPattern *patterns = getEvalPatterns();
+
+    auto add = [&](uint32_t value) {
+        for (int i = 0; i < 4; i++, value >>= 8)
+        {
+            hash ^= value & 0xFF;
+            hash *= 0x01000193U;
+        }
+    };
+
+    for (int i = 0; i < EVAL_PATTERN_INSTANCES; i++)
+    {
+        add(patterns[i].type);
+        add(patterns[i].size);
+        for (int k = 0; k < patterns[i].size; k++)
+            add(patterns[i].squares[k]);
+    }
+    for (int type = 0; type < EVAL_PATTERN_TYPES; type++)
+        add(getPatternOffset(type));
+    add(getMobilityOffset());
+
+    return hash;
+}
+
+static uint64_t getDataSize()
+{
+    return (uint64_t)EVAL_STAGES * getEvalStageSize() * sizeof(int16_t);
+}
+
+static bool checkHeader(const MappedFile &mappedFile, std::string &error)
+{
+    const WeightFileHeader *header = (const WeightFileHeader *)mappedFile.data;
+
+    if (mappedFile.size < sizeof(WeightFileHeader) ||
+        memcmp(header->magic, WEIGHT_FILE_MAGIC, sizeof(header->magic)))
+        error = "not a weight file";
+    else if (header->version != WEIGHT_FILE_VERSION)
+        error = "unsupported version " + std::to_string(header->version);
+    else if (header->headerSize != sizeof(WeightFileHeader))
+        error = "bad header size";
+    else if (header->stages != EVAL_STAGES ||
+             header->stageSize != (uint32_t)getEvalStageSize() ||
+             header->patternInstances != EVAL_PATTERN_INSTANCES ||
+             header->layoutHash != getLayoutHash())
+        error = "pattern layout does not match this build";
+    else if (header->dataSize != getDataSize() ||
+             mappedFile.size != sizeof(WeightFileHeader) + header->dataSize)
+        error = "bad file size";
+    else
+        return true;
+
+    return false;
+}
+
+static bool checkData(const MappedFile &mappedFile, std::string &error)
+{
+    const WeightFileHeader *header = (const WeightFileHeader *)mappedFile.data;
+
+    if (getChecksum(mappedFile.data + sizeof(WeightFileHeader), header->dataSize) !=
+        header->checksum)
+    {
+        error = "checksum mismatch";
+        return false;
+    }
+
+    return true;
+}
+
+bool saveWeightFile(const char *path, const int16_t *weights, std::string &error)
+{
+    WeightFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, WEIGHT_FILE_MAGIC, sizeof(header.magic));
+    header.version = WEIGHT_FILE_VERSION;
+    header.headerSize = sizeof(WeightFileHeader);
+    header.stages = EVAL_STAGES;
+    header.stageSize = getEvalStageSize();
+    header.patternInstances = EVAL_PATTERN_INSTANCES;
+    header.layoutHash = getLayoutHash();
+    header.dataSize = getDataSize();
+    header.checksum = getChecksum(weights, header.dataSize);
+
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        error = std::string("cannot create ") + path;
+        return false;
+    }
+
+    bool ok = (fwrite(&header, sizeof(header), 1, file) == 1) &&
+              (fwrite(weights, header.dataSize, 1, file) == 1);
+    ok = !fclose(file) && ok;
+    if (!ok)
+        error = std::string("cannot write ") + path;
+
+    return ok;
+}
+
+const int16_t *mapWeightFile(const char *path, MappedFile &mappedFile,
+                             std::string &error, bool verify)
+{
+    if (!mapFile(path, mappedFile))
+    {
+        error = std::string("cannot open ") + path;
+        return nullptr;
+    }
+
+    if (!checkHeader(mappedFile, error) ||
+        (verify && !checkData(mappedFile, error)))
+    {
+        unmapFile(mappedFile);
+        return nullptr;
+    }
+
+    return (const int16_t *)(mappedFile.data + sizeof(WeightFileHeader));
+}
+
+bool loadWeightFile(const char *path, std::string &error, bool verify)
+{
+    MappedFile mappedFile;
+    const int16_t *weights = mapWeightFile(path, mappedFile, error, verify);
+    if (!weights)
+        return false;
+
+    setEvalWeights(weights);
+    unmapFile(loadedFile);
+    loadedFile = mappedFile;
+
+    return true;
+}
+
+bool validateWeightFile(const char *path, std::string &error)
+{
+    MappedFile mappedFile;
+    if (!mapFile(path, mappedFile))
+    {
+        error = std::string("cannot open ") + path;
+        return false;
+    }
+
+    bool ok = checkHeader(mappedFile, error) && checkData(mappedFile, error);
+    unmapFile(mappedFile);
+
+    return ok;
+}
+
+void unloadWeightFile()
+{
+    setEvalWeights(nullptr);
+    unmapFile(loadedFile);
+}
+
+bool loadDefaultWeightFile()
+{
+    const char *path = getenv("REVERSI_WEIGHTS");
+    bool required = (path && *path);
+    if (!required)
+        path = WEIGHT_FILE_DEFAULT_NAME;
+
+    std::string error;
+    if (loadWeightFile(path, error))
+        return true;
+
+    // Sin archivo por defecto: se usan los pesos incorporados
+    FILE *file = required ? NULL : fopen(path, "rb");
+    if (required || file)
+        LOG_WARN("weights: %s: %s, using built-in weights", path, error.c_str());
+    if (file)
+        fclose(file);
+
+    return false;
+}
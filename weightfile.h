@@ -0,0 +1,98 @@
+/**
+ * @brief Implements the binary evaluation weight file
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#ifndef WEIGHTFILE_H
+#define WEIGHTFILE_H
+
+#include <cstdint>
+#include <string>
+
+#include "mappedfile.h"
+
+#define WEIGHT_FILE_MAGIC "RVSIWGT"
+#define WEIGHT_FILE_VERSION 1
+
+// Loaded at startup if present; REVERSI_WEIGHTS overrides it
+#define WEIGHT_FILE_DEFAULT_NAME "reversi.weights"
+
+/**
+ * @brief Weight file header (64 bytes, little-endian). The int16 weights
+ * follow it: EVAL_STAGES stages of getEvalStageSize() weights each, used in
+ * place from the read-only mapping.
+ */
+struct WeightFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t stages;
+    uint32_t stageSize;
+    uint32_t patternInstances;
+    uint32_t layoutHash; // Pattern squares and table sizes
+    uint64_t dataSize;   // Bytes of weights
+    uint64_t checksum;   // FNV-1a of the weights
+    uint8_t reserved[16];
+};
+
+/**
+ * @brief Writes weights in the binary format.
+ *
+ * @param path The file path.
+ * @param weights EVAL_STAGES * stage size weights.
+ * @param error Receives an error message on failure.
+ * @return Whether the file was written.
+ */
+bool saveWeightFile(const char *path, const int16_t *weights, std::string &error);
+
+/**
+ * @brief Maps a weight file read-only and makes evaluate use it. Processes
+ * loading the same file share one page cache copy. Must not be called while
+ * a search is running.
+ *
+ * @param path The file path.
+ * @param error Receives an error message on failure.
+ * @param verify Also verify the checksum (reads the whole file).
+ * @return Whether the file was loaded; if not, the weights are unchanged.
+ */
+bool loadWeightFile(const char *path, std::string &error, bool verify = false);
+
+/**
+ * @brief Maps a weight file read-only without installing it, e.g. to give
+ * one engine of a tournament its own weights (see initEvalState).
+ *
+ * @param path The file path.
+ * @param mappedFile Receives the mapping; the caller unmaps it.
+ * @param error Receives an error message on failure.
+ * @param verify Also verify the checksum (reads the whole file).
+ * @return The weights, or nullptr on failure.
+ */
+const int16_t *mapWeightFile(const char *path, MappedFile &mappedFile,
+                             std::string &error, bool verify = false);
+
+/**
+ * @brief Checks a weight file: header, layout, size and checksum.
+ *
+ * @param path The file path.
+ * @param error Receives an error message on failure.
+ * @return Whether the file is valid.
+ */
+bool validateWeightFile(const char *path, std::string &error);
+
+/**
+ * @brief Unmaps the loaded weight file and restores the default weights.
+ */
+void unloadWeightFile();
+
+/**
+ * @brief Loads $REVERSI_WEIGHTS, or WEIGHT_FILE_DEFAULT_NAME if it exists.
+ * A missing default file is not an error; invalid files are reported.
+ *
+ * @return Whether a weight file was loaded.
+ */
+bool loadDefaultWeightFile();
+
+#endif
@@ -0,0 +1,206 @@
+/**
+ * @brief Weight file tool: export, convert, dump and validate
+ * @author Marc S. Ressl
+ *
+ * @copyright Copyright (c) 2023-2024
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "eval.h"
+#include "weightfile.h"
+
+/*
+ * Text format, one weight per line, '#' starts a comment:
+ *
+ *   stage <n>
+ *   <pattern name> <index> <value>
+ *   mobility <value>
+ *   potential <value>
+ *
+ * Weights not listed are zero.
+ */
+
+static void printUsage()
+{
+    printf("usage: weights export <out.bin>           write the built-in weights\n"
+           "       weights convert <in.txt> <out.bin> text to binary\n"
+           "       weights dump <in.bin> [out.txt]    binary to text\n"
+           "       weights validate <file.bin>        check header and checksum\n");
+}
+
+static int findPatternType(const char *name)
+{
+    for (int type = 0; type < EVAL_PATTERN_TYPES; type++)
+        if (!strcmp(getPatternName(type), name))
+            return type;
+    return -1;
+}
+
+static int getPatternSize(int type)
+{
+    int end = (type + 1 < EVAL_PATTERN_TYPES) ? getPatternOffset(type + 1)
+                                              : getMobilityOffset();
+    return end - getPatternOffset(type);
+}
+
+static bool readText(const char *path, std::vector<int16_t> &weights)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        fprintf(stderr, "weights: cannot open %s\n", path);
+        return false;
+    }
+
+    int stageSize = getEvalStageSize();
+    weights.assign(EVAL_STAGES * stageSize, 0);
+
+    char line[256];
+    int lineNumber = 0;
+    int stage = -1;
+    bool ok = true;
+
+    while (ok && fgets(line, sizeof(line), file))
+    {
+        lineNumber++;
+        char *comment = strchr(line, '#');
+        if (comment)
+            *comment = '\0';
+
+        char name[64];
+        int a, b;
+        int fields = sscanf(line, "%63s %d %d", name, &a, &b);
+        if (fields <= 0)
+            continue;
+
+        int offset = -1;
+        int value = 0;
+        if (!strcmp(name, "stage") && fields == 2 && a >= 0 && a < EVAL_STAGES)
+            stage = a;
+        else if (!strcmp(name, "mobility") && fields == 2)
+            offset = getMobilityOffset(), value = a;
+        else if (!strcmp(name, "potential") && fields == 2)
+            offset = getMobilityOffset() + 1, value = a;
+        else
+        {
+            int type = findPatternType(name);
+            if (type >= 0 && fields == 3 && a >= 0 && a < getPatternSize(type))
+                offset = getPatternOffset(type) + a, value = b;
+            else
+                ok = false;
+        }
+
+        if (ok && offset >= 0)
+        {
+            if (stage < 0 || value < INT16_MIN || value > INT16_MAX)
+                ok = false;
+            else
+                weights[stage * stageSize + offset] = (int16_t)value;
+        }
+
+        if (!ok)
+            fprintf(stderr, "weights: %s:%d: invalid line\n", path, lineNumber);
+    }
+
+    fclose(file);
+    return ok;
+}
+
+static bool writeText(FILE *file, const int16_t *weights)
+{
+    int stageSize = getEvalStageSize();
+
+    fprintf(file, "# Reversi evaluation weights, format version %d\n", WEIGHT_FILE_VERSION);
+    for (int stage = 0; stage < EVAL_STAGES; stage++)
+    {
+        const int16_t *stageWeights = weights + stage * stageSize;
+
+        fprintf(file, "stage %d\n", stage);
+        for (int type = 0; type < EVAL_PATTERN_TYPES; type++)
+        {
+            const int16_t *table = stageWeights + getPatternOffset(type);
+            for (int index = 0; index < getPatternSize(type); index++)
+                if (table[index])
+                    fprintf(file, "%s %d %d\n", getPatternName(type), index, table[index]);
+        }
+        fprintf(file, "mobility %d\n", stageWeights[getMobilityOffset()]);
+        fprintf(file, "potential %d\n", stageWeights[getMobilityOffset() + 1]);
+    }
+
+    return !ferror(file);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        printUsage();
+        return 1;
+    }
+
+    const char *command = argv[1];
+    std::string error;
+
+    if (!strcmp(command, "export") && argc == 3)
+    {
+        if (!saveWeightFile(argv[2], getEvalWeights(), error))
+        {
+            fprintf(stderr, "weights: %s\n", error.c_str());
+            return 1;
+        }
+    }
+    else if (!strcmp(command, "convert") && argc == 4)
+    {
+        std::vector<int16_t> weights;
+        if (!readText(argv[2], weights))
+            return 1;
+        if (!saveWeightFile(argv[3], &weights[0], error))
+        {
+            fprintf(stderr, "weights: %s\n", error.c_str());
+            return 1;
+        }
+    }
+    else if (!strcmp(command, "dump") && (argc == 3 || argc == 4))
+    {
+        if (!loadWeightFile(argv[2], error, true))
+        {
+            fprintf(stderr, "weights: %s: %s\n", argv[2], error.c_str());
+            return 1;
+        }
+
+        FILE *file = (argc == 4) ? fopen(argv[3], "w") : stdout;
+        if (!file)
+        {
+            fprintf(stderr, "weights: cannot create %s\n", argv[3]);
+            return 1;
+        }
+        bool ok = writeText(file, getEvalWeights());
+        if (file != stdout)
+            ok = !fclose(file) && ok;
+        unloadWeightFile();
+        if (!ok)
+            return 1;
+    }
+    else if (!strcmp(command, "validate") && argc == 3)
+    {
+        if (!validateWeightFile(argv[2], error))
+        {
+            printf("%s: INVALID (%s)\n", argv[2], error.c_str());
+            return 2;
+        }
+        printf("%s: OK (version %d, %d stages, %d weights per stage)\n",
+               argv[2], WEIGHT_FILE_VERSION, EVAL_STAGES, getEvalStageSize());
+    }
+    else
+    {
+        printUsage();
+        return 1;
+    }
+
+    return 0;
+}